@@ -0,0 +1,323 @@
+/********************************************************************
+ * Copyright (c) 2014, Andrea Zito
+ * All rights reserved.
+ *
+ * License: BSD3
+ ********************************************************************/
+
+/*
+ * Micro benchmarks of the framework itself.
+ *
+ * Each benchmark is run twice: once in a tight loop for a fixed amount of
+ * time to measure throughput, and once timing every single operation to
+ * compute latency percentiles. Results are printed on stdout as CSV, one
+ * line per benchmark, so that runs of different commits can be diffed or
+ * joined on the first two columns.
+ *
+ * Internal entry points (e.g. QCC_forAll and QCC_freeResult) are reached
+ * through quickcheck4c_internal.h so that they can be measured too.
+ *
+ * Usage: bench [seconds per benchmark] [seed]
+ */
+
+#include "quickcheck4c_internal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SAMPLES 20000
+#define BENCH_LABELS 1024
+
+static double benchSeconds = 0.2;
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int compareNs(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * A benchmark operation: op is called with the benchmark context and
+ * performs a single unit of work (e.g. generate and release a value).
+ */
+typedef void (*BenchOp)(void *ctx);
+
+static void benchRun(const char *name, const char *param, BenchOp op, void *ctx) {
+  static uint64_t samples[BENCH_SAMPLES];
+  uint64_t budget = (uint64_t) (benchSeconds * 1e9);
+  uint64_t ops = 0, start, elapsed;
+  int i, n;
+
+  /* Warmup */
+  for (i=0; i<100; i++) op(ctx);
+
+  /* Throughput: batches of operations until the time budget is spent */
+  start = nowNs();
+  do {
+    for (i=0; i<64; i++) op(ctx);
+    ops += 64;
+    elapsed = nowNs() - start;
+  } while (elapsed < budget);
+
+  /* Latency: every operation timed on its own, within the same budget */
+  start = nowNs();
+  for (n=0; n<BENCH_SAMPLES && (n < 100 || nowNs() - start < budget); n++) {
+    uint64_t t = nowNs();
+    op(ctx);
+    samples[n] = nowNs() - t;
+  }
+  qsort(samples, n, sizeof(uint64_t), compareNs);
+
+  printf("%s,%s,%llu,%.2f,%.0f,%llu,%llu,%llu,%llu\n", name, param,
+         (unsigned long long) ops, (double) elapsed / ops, ops * 1e9 / elapsed,
+         (unsigned long long) samples[n/2],
+         (unsigned long long) samples[(int) (n*0.9)],
+         (unsigned long long) samples[(int) (n*0.99)],
+         (unsigned long long) samples[n-1]);
+  fflush(stdout);
+}
+
+/***********************************************************************
+ *  Generators
+ ***********************************************************************/
+typedef struct {
+  const char *name;
+  QCC_gen gen;
+} ScalarBench;
+
+typedef struct {
+  const char *name;
+  QCC_GenValue* (*gen)(int len);
+  int len;
+} ArrayBench;
+
+static QCC_GenValue* genIntR() {
+  return QCC_genIntR(-1000, 1000);
+}
+
+static QCC_GenValue* genDoubleR() {
+  return QCC_genDoubleR(-1.0, 1.0);
+}
+
+static QCC_GenValue* genStringL(int len) {
+  return QCC_genStringL(len);
+}
+
+static void scalarOp(void *ctx) {
+  ScalarBench *b = ctx;
+  QCC_freeGenValue(b->gen());
+}
+
+static void arrayOp(void *ctx) {
+  ArrayBench *b = ctx;
+  QCC_freeGenValue(b->gen(b->len));
+}
+
+static void benchGenerators() {
+  ScalarBench scalars[] = {
+    { "genLong", QCC_genLong },
+    { "genInt", QCC_genInt },
+    { "genIntR", genIntR },
+    { "genDouble", QCC_genDouble },
+    { "genDoubleR", genDoubleR },
+    { "genFloat", QCC_genFloat },
+    { "genBoolean", QCC_genBoolean },
+    { "genChar", QCC_genChar },
+  };
+  ArrayBench arrays[] = {
+    { "genArrayLongL", QCC_genArrayLongL },
+    { "genArrayIntL", QCC_genArrayIntL },
+    { "genArrayDoubleL", QCC_genArrayDoubleL },
+    { "genArrayFloatL", QCC_genArrayFloatL },
+    { "genArrayBooleanL", QCC_genArrayBooleanL },
+    { "genArrayCharL", QCC_genArrayCharL },
+    { "genStringL", genStringL },
+  };
+  int lengths[] = { 1, 16, 256, 4096 };
+  char param[32];
+  unsigned i, j;
+
+  for (i=0; i<sizeof(scalars)/sizeof(scalars[0]); i++)
+    benchRun(scalars[i].name, "-", scalarOp, &scalars[i]);
+
+  for (i=0; i<sizeof(arrays)/sizeof(arrays[0]); i++) {
+    for (j=0; j<sizeof(lengths)/sizeof(lengths[0]); j++) {
+      arrays[i].len = lengths[j];
+      snprintf(param, sizeof(param), "len=%d", lengths[j]);
+      benchRun(arrays[i].name, param, arrayOp, &arrays[i]);
+    }
+  }
+}
+
+/***********************************************************************
+ *  Show
+ ***********************************************************************/
+typedef struct {
+  QCC_GenValue *value;
+  QCC_Sink sink;
+} ShowBench;
+
+/*
+ * Reference show of int arrays as done before sinks: every element is
+ * formatted into its own malloc'd string, then the strings are measured
+ * and concatenated into the result.
+ */
+static char* legacyShowInt(void *value) {
+  char *vc = malloc(sizeof(char) * 12);
+  snprintf(vc, 12, "%d", *(int *) value);
+  vc[11] = 0;
+  return vc;
+}
+
+static char* legacyShowArrayInt(int *value, int len) {
+  char **valStr = malloc(sizeof(char *) * (len ? len : 1));
+  int valStrLen = 0, currLen = 1;
+  char *str;
+  int i;
+
+  for (i=0; i<len; i++) {
+    valStr[i] = legacyShowInt(value + i);
+    valStrLen += strlen(valStr[i]);
+  }
+  str = malloc(sizeof(char) * (valStrLen + 2 + 2*len + 1));
+  sprintf(str, "[");
+  for (i=0; i<len; i++) {
+    if (i == 0) {
+      sprintf(str + currLen, "%s", valStr[i]);
+    } else {
+      sprintf(str + currLen, ", %s", valStr[i]);
+      currLen += 2;
+    }
+    currLen += strlen(valStr[i]);
+    free(valStr[i]);
+  }
+  sprintf(str + currLen, "]");
+  free(valStr);
+  return str;
+}
+
+static void showOp(void *ctx) {
+  ShowBench *b = ctx;
+  free(legacyShowArrayInt(b->value->value, b->value->n));
+}
+
+static void writeOp(void *ctx) {
+  ShowBench *b = ctx;
+  b->sink.len = 0;
+  QCC_writeGenValue(&b->sink, b->value);
+}
+
+static void benchShow() {
+  int lengths[] = { 16, 256, 4096 };
+  char param[32];
+  unsigned i;
+
+  for (i=0; i<sizeof(lengths)/sizeof(lengths[0]); i++) {
+    ShowBench b;
+    /* Array lengths are drawn in [0, len), ask for one more element */
+    while ((b.value = QCC_genArrayIntL(lengths[i] + 1))->n != lengths[i]) QCC_freeGenValue(b.value);
+    QCC_initBufferSink(&b.sink, NULL, 0);
+
+    snprintf(param, sizeof(param), "len=%d", lengths[i]);
+    benchRun("legacyShowArrayInt", param, showOp, &b);
+    benchRun("writeArrayInt", param, writeOp, &b);
+
+    QCC_freeSink(&b.sink);
+    QCC_freeGenValue(b.value);
+  }
+}
+
+/***********************************************************************
+ *  Runner overhead
+ ***********************************************************************/
+static QCC_TestStatus trivialProp(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
+  return QCC_OK;
+}
+
+static void forAllOp(void *ctx) {
+  QCC_Result res = QCC_forAll(trivialProp, 1, QCC_genInt);
+  QCC_freeResult(&res);
+}
+
+static void forAll3Op(void *ctx) {
+  QCC_Result res = QCC_forAll(trivialProp, 3, QCC_genInt, QCC_genInt, QCC_genInt);
+  QCC_freeResult(&res);
+}
+
+static void planStepOp(void *ctx) {
+  QCC_planStep(ctx);
+}
+
+static void benchRunners() {
+  QCC_gen gens[] = { QCC_genInt, QCC_genInt, QCC_genInt };
+  QCC_Plan *plan;
+
+  benchRun("forAll+freeResult", "gens=1", forAllOp, NULL);
+  benchRun("forAll+freeResult", "gens=3", forAll3Op, NULL);
+
+  plan = QCC_newPlan(trivialProp, 1, gens);
+  benchRun("planStep", "gens=1", planStepOp, plan);
+  QCC_freePlan(plan);
+
+  plan = QCC_newPlan(trivialProp, 3, gens);
+  benchRun("planStep", "gens=3", planStepOp, plan);
+  QCC_freePlan(plan);
+}
+
+/***********************************************************************
+ *  Label aggregation
+ ***********************************************************************/
+static char labels[BENCH_LABELS][16];
+static int labelsDistinct;
+static int labelsPerCase;
+
+static QCC_TestStatus labelProp(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
+  int a = *QCC_getValue(vals, 0, int*);
+  int i;
+
+  for (i=0; i<labelsPerCase; i++)
+    QCC_label(stamp, labels[(unsigned) (a + i) % labelsDistinct]);
+  return QCC_OK;
+}
+
+static void benchLabels() {
+  int distinct[] = { 1, 16, 256, 1024 };
+  int perCase[] = { 1, 4 };
+  QCC_gen gens[] = { QCC_genInt };
+  char param[32];
+  unsigned i, j;
+
+  for (i=0; i<BENCH_LABELS; i++) snprintf(labels[i], sizeof(labels[i]), "label-%u", i);
+
+  for (i=0; i<sizeof(distinct)/sizeof(distinct[0]); i++) {
+    for (j=0; j<sizeof(perCase)/sizeof(perCase[0]); j++) {
+      QCC_Plan *plan = QCC_newPlan(labelProp, 1, gens);
+      labelsDistinct = distinct[i];
+      labelsPerCase = perCase[j];
+      snprintf(param, sizeof(param), "distinct=%d;perCase=%d", distinct[i], perCase[j]);
+      benchRun("planStep+label", param, planStepOp, plan);
+      QCC_freePlan(plan);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) benchSeconds = atof(argv[1]);
+  QCC_init(argc > 2 ? atoi(argv[2]) : 42);
+
+  printf("benchmark,param,ops,ns_per_op,ops_per_sec,p50_ns,p90_ns,p99_ns,max_ns\n");
+  benchGenerators();
+  benchShow();
+  benchRunners();
+  benchLabels();
+
+  return 0;
+}
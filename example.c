@@ -8,7 +8,10 @@
 #include "quickcheck4c.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
 
 QCC_GenValue* myRangedGenInt10() {
   return QCC_genIntR(-5, 5);
@@ -70,11 +73,20 @@ QCC_TestStatus mulFloatAssociativity(QCC_GenValue **vals, int len, QCC_Stamp **s
   return (a*b)*c == a*(b*c);
 }
 
+uint64_t mulFloatAssociativityBatch(void **columns, int n) {
+  float *a = columns[0], *b = columns[1], *c = columns[2];
+  uint64_t failing = 0;
+  int i;
+
+  for (i=0; i<n; i++) failing |= (uint64_t) ((a[i]*b[i])*c[i] != a[i]*(b[i]*c[i])) << i;
+  return failing;
+}
+
 QCC_TestStatus sumEvenInt(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
   int a = *QCC_getValue(vals, 0, int*);
   int b = *QCC_getValue(vals, 1, int*);
 
-  return (a + b) % 2 == 0;
+  return ((long) a + b) % 2 == 0;
 }
 
 QCC_TestStatus sumEvenKindInt(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
@@ -84,7 +96,7 @@ QCC_TestStatus sumEvenKindInt(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
   if (a % 2 == 0 && b % 2 == 0) QCC_label(stamp, "even");
   if (a % 2 != 0 && b % 2 != 0) QCC_label(stamp, "odd");
 
-  return QCC_imply(a % 2 == b % 2,  (a + b) % 2 == 0);
+  return QCC_imply(a % 2 == b % 2,  ((long) a + b) % 2 == 0);
 }
 
 QCC_TestStatus rangedIntGen(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
@@ -131,8 +143,8 @@ QCC_TestStatus disjunction(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
   int a = *QCC_getValue(vals, 0, int*);
   int b = *QCC_getValue(vals, 1, int*);
 
-  return QCC_or(QCC_imply(a % 2 == b % 2, (a + b) % 2 == 0),
-                QCC_imply(b % 2 != b % 2, (a + b) % 2 != 0));
+  return QCC_or(QCC_imply(a % 2 == b % 2, ((long) a + b) % 2 == 0),
+                QCC_imply(b % 2 != b % 2, ((long) a + b) % 2 != 0));
 }
 
 QCC_TestStatus xdisjunction(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
@@ -143,6 +155,104 @@ QCC_TestStatus xdisjunction(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
 }
 
 
+/*
+ * A shared counter whose add returns the previous value, modeled by a
+ * long. The racy counter reads and writes the value in two steps.
+ */
+typedef struct Counter {
+  atomic_long value;
+  int racy;
+} Counter;
+
+void* newCounter() {
+  Counter *c = malloc(sizeof(Counter));
+  atomic_init(&c->value, 0);
+  c->racy = 0;
+  return c;
+}
+
+void* newRacyCounter() {
+  Counter *c = newCounter();
+  c->racy = 1;
+  return c;
+}
+
+void freeCounter(void *sut) {
+  free(sut);
+}
+
+QCC_GenValue* genCounterAmount(const void *model) {
+  return QCC_genIntR(1, 10);
+}
+
+long counterAdd(void *sut, QCC_GenValue *arg) {
+  Counter *c = sut;
+  int n = *(int *) arg->value;
+  long prev;
+
+  if (!c->racy) return atomic_fetch_add(&c->value, n);
+  prev = atomic_load(&c->value);
+  sched_yield();
+  atomic_store(&c->value, prev + n);
+  return prev;
+}
+
+long counterGet(void *sut, QCC_GenValue *arg) {
+  return atomic_load(&((Counter *) sut)->value);
+}
+
+QCC_Boolean counterPost(const void *model, QCC_GenValue *arg, long result) {
+  return result == *(const long *) model;
+}
+
+void counterAddNext(void *model, QCC_GenValue *arg) {
+  *(long *) model += *(int *) arg->value;
+}
+
+QCC_Command counterCommands[] = {
+  { .name="add", .pre=NULL, .gen=genCounterAmount, .run=counterAdd, .post=counterPost, .next=counterAddNext },
+  { .name="get", .pre=NULL, .gen=NULL, .run=counterGet, .post=counterPost, .next=NULL },
+};
+
+QCC_StateMachine counterMachine = { .modelSize=sizeof(long), .initModel=NULL, .newSut=newCounter,
+                                    .freeSut=freeCounter, .commands=counterCommands, .commandsN=2 };
+
+QCC_StateMachine racyCounterMachine = { .modelSize=sizeof(long), .initModel=NULL, .newSut=newRacyCounter,
+                                        .freeSut=freeCounter, .commands=counterCommands, .commandsN=2 };
+
+
+/*
+ * Insertion sort of a copy of the array, returning its largest element:
+ * its time is quadratic in the number of inversions of the array.
+ */
+int insertionSort(const int *src, int n) {
+  int *a = malloc(sizeof(int) * (n ? n : 1));
+  int i, j, x, max;
+
+  memcpy(a, src, sizeof(int) * n);
+  for (i=1; i<n; i++) {
+    x = a[i];
+    for (j=i; j>0 && a[j-1] > x; j--) a[j] = a[j-1];
+    a[j] = x;
+  }
+  max = n ? a[n-1] : 0;
+  free(a);
+
+  return max;
+}
+
+/* Keeps the benchmarked sorts from being optimized away */
+volatile int insertionSortSink;
+
+QCC_TestStatus insertionSortTime(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
+  insertionSortSink = insertionSort(vals[0]->value, vals[0]->n);
+
+  return QCC_OK;
+}
+
+void insertionSortBench(QCC_GenValue **vals, int len) {
+  insertionSortSink = insertionSort(vals[0]->value, vals[0]->n);
+}
 
 int main(int argc, char **argv) {
   QCC_init(0);
@@ -159,12 +269,19 @@ int main(int argc, char **argv) {
   printf("Testing float multiplication associativity\n");
   QCC_testForAll(100, 1000, mulFloatAssociativity, 3, QCC_genFloat, QCC_genFloat, QCC_genFloat);
 
+  printf("Testing float multiplication associativity (batch)\n");
+  QCC_testForAllBatch(10000, 1000, mulFloatAssociativityBatch, mulFloatAssociativity, 3,
+                      QCC_columnFloat(), QCC_columnFloat(), QCC_columnFloat());
+
   printf("Testing int sum to even\n");
   QCC_testForAll(100, 1000, sumEvenInt, 2, QCC_genInt, QCC_genInt);
 
   printf("Testing int sum to even (same kind)\n");
   QCC_testForAll(1000, 10000, sumEvenKindInt, 2, QCC_genInt, QCC_genInt);
 
+  printf("Testing int sum to even (same kind, enumerated)\n");
+  QCC_testEnumerate(20, QCC_DIAGONAL, 1000, sumEvenKindInt, 2, QCC_genInt, QCC_genInt);
+
   printf("Testing ranged int generator\n");
   QCC_testForAll(100, 1000, rangedIntGen, 1, myRangedGenInt10);
 
@@ -183,5 +300,26 @@ int main(int argc, char **argv) {
   printf("Testing property exclusive disjunction\n");
   QCC_testForAll(100, 1000, xdisjunction, 1, QCC_genInt);
 
+  printf("Testing insertion sort latency\n");
+  QCC_testLatency(1000, 1000, (QCC_LatencyBudget) { .maxSeconds=1e-3, .percentile=0.99, .percentileSeconds=1e-4 },
+                  insertionSortTime, 1, QCC_genArrayInt);
+
+  /* Mutations sort and reverse runs, climbing towards reverse sorted arrays */
+  printf("Searching insertion sort worst case\n");
+  QCC_searchWorstCase(1000, 1000, 0, insertionSortTime, 1, QCC_genArrayInt);
+
+  printf("Benchmarking insertion sort\n");
+  QCC_setBenchTime(0.05, 0.2);
+  QCC_benchForAll("insertionSort", 256, insertionSortBench, 1, QCC_genArrayInt);
+
+  printf("Testing counter against its model\n");
+  QCC_testStateMachine(100, 1000, &counterMachine);
+
+  printf("Testing counter linearizability\n");
+  QCC_testStateMachineParallel(2, 100, 1000, &counterMachine);
+
+  printf("Testing racy counter linearizability\n");
+  QCC_testStateMachineParallel(2, 100, 1000, &racyCounterMachine);
+
   return 0;
 }
@@ -5,598 +5,5887 @@
  * License: BSD3
  ********************************************************************/
 
-#include "quickcheck4c.h"
+#if defined(QCC_PROFILE) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "quickcheck4c_internal.h"
 
 #include <stdint.h>
 #include <limits.h>
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fnmatch.h>
 
-typedef void (*QCC_genRaw)(void *ptr);
-typedef void (*QCC_genRawR)(void *ptr, void *from, void *to);
+#if !defined(QCC_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QCC_X86_SIMD
+#include <immintrin.h>
+#endif
 
-struct QCC_Stamp {
+#ifdef QCC_PROFILE
+#include <dlfcn.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define QCC_PROFILE_TSC
+#endif
+#endif
+
+typedef int (*QCC_shrinkRaw)(void *ptr, void *bounds, int idx, void *out);
+typedef int (*QCC_nudgeRaw)(void *ptr, void *bounds, QCC_Rng *rng, void *out);
+typedef void (*QCC_fillRaw)(QCC_Rng *rng, void *buf, int n);
+typedef void (*QCC_fillRawR)(QCC_Rng *rng, void *buf, int n, const void *from, const void *to);
+
+/*
+ * Stamps are hash tables of labels. Entries are kept in insertion order
+ * and slots index them through open addressing. Tables are reused across
+ * cases: resetting a table only zeroes the counts of the labels touched
+ * since the last reset, so labels are copied once per run rather than once
+ * per case. A table merged into another one caches, for each label, the
+ * index of the matching entry in the destination.
+ */
+typedef struct QCC_StampEntry {
   char *label;
+  uint64_t hash;
   int n;
-  struct QCC_Stamp *next;
-};
+  int link;
+} QCC_StampEntry;
 
-typedef struct QCC_Result {
-  QCC_TestStatus status;
-  QCC_Stamp *stamps;
-  QCC_GenValue **arguments;
-  int argumentsN;
-} QCC_Result;
+struct QCC_Stamp {
+  QCC_StampEntry *entries;
+  int entriesN;
+  int entriesCap;
+  int *slots;
+  int slotsCap;
+  int *touched;
+  int touchedN;
+  struct QCC_Stamp *linked;
+};
 
 enum QCC_deref_type { NONE, LONG, INT, FLOAT, DOUBLE, CHAR };
 
-void QCC_init(int seed) {
-  if (seed) srandom(seed);
-  else srandom(time(NULL));
-}
-
 /***********************************************************************
- *  Generators helper functions
+ *  Random number generation
  ***********************************************************************/
-static char* QCC_showSimpleValue(void *value, enum QCC_deref_type dt, int maxsize, const char *format) {
-  char *vc = malloc(sizeof(char) * (maxsize+1));
 
-  switch (dt) {
-  case LONG:
-    snprintf(vc, maxsize+1, format, *(long*)value);
-    break;
-  case INT:
-    snprintf(vc, maxsize+1, format, *(int*)value);
-    break;
-  case FLOAT:
-    snprintf(vc, maxsize+1, format, *(float*)value);
-    break;
-  case DOUBLE:
-    snprintf(vc, maxsize+1, format, *(double*)value);
-    break;
-  case CHAR:
-    snprintf(vc, maxsize+1, format, *(char*)value);
-    break;
-  default:
-    snprintf(vc, maxsize+1, format, *(int*)value);
-    break;
-  }
-  vc[maxsize]=0;
-  return vc;
-}
+/*
+ * Each thread owns a default xoshiro256** stream so that generators never
+ * contend on shared state. The default stream of a thread that never called
+ * QCC_init starts from seed 1, just like an unseeded random().
+ */
+static _Thread_local QCC_Rng QCC_threadRng;
+static _Thread_local int QCC_threadRngSeeded = 0;
+static _Thread_local QCC_Rng *QCC_currentRng = NULL;
+/* Set whenever the generator is handed out, see QCC_generateTuple */
+static _Thread_local QCC_Boolean QCC_rngUsed = QCC_FALSE;
 
-static void QCC_freeSimpleValue(void *value) {
-  free(value);
+static inline uint64_t QCC_rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
 }
 
-QCC_GenValue* QCC_initGenValue(void *value, int n, QCC_showValue show, QCC_freeValue free) {
-  QCC_GenValue *gv = malloc(sizeof(QCC_GenValue));
-  *gv = (QCC_GenValue) { .value=value, .n=n, .show=show, .free=free };
+static inline uint64_t QCC_splitMix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
 
-  return gv;
+void QCC_rngSeed(QCC_Rng *rng, uint64_t seed) {
+  int i;
+  for (i=0; i<4; i++) rng->s[i] = QCC_splitMix64(&seed);
 }
 
+uint64_t QCC_rngNext(QCC_Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = QCC_rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
 
-/***********************************************************************
- *  Generators implementations
- ***********************************************************************/
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = QCC_rotl(s[3], 45);
 
-static char* QCC_showLong(void *value, int len) {
-  return QCC_showSimpleValue(value, LONG, 21, "%ld");
+  return result;
 }
 
-void QCC_genLongAtR(long *l, long *from, long *to) {
-  long _from = *from;
-  long _to = *to;
-  unsigned long n = _to - _from;
+/* High half of the 128 bits product a * b, the low half goes to low */
+static inline uint64_t QCC_mulHigh(uint64_t a, uint64_t b, uint64_t *low) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 m = (unsigned __int128) a * b;
+  *low = (uint64_t) m;
+  return (uint64_t) (m >> 64);
+#else
+  uint64_t aL = a & 0xffffffffULL, aH = a >> 32, bL = b & 0xffffffffULL, bH = b >> 32;
+  uint64_t lh = aL * bH, hl = aH * bL;
+  uint64_t mid = ((aL * bL) >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+  *low = a * b;
+  return aH * bH + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
 
-  if (n > RAND_MAX) {
-    _from = _from + n/2 - RAND_MAX/2;
-    _to = _from + n/2 + RAND_MAX/2;
-    n = _to - _from;
+/*
+ * Bounded values are drawn by multiply-shift with rejection (Lemire): the
+ * high half of raw * n is uniform in [0, n) once the raw values whose low
+ * half is below 2^64 mod n are rejected. The threshold costs a division,
+ * only computed when the low half is below n, which is rare unless n is
+ * close to 2^64.
+ */
+uint64_t QCC_rngBelow(QCC_Rng *rng, uint64_t n) {
+  uint64_t low, high;
+
+  if (n == 0) return 0;
+  high = QCC_mulHigh(QCC_rngNext(rng), n, &low);
+  if (low < n) {
+    uint64_t threshold = -n % n;
+    while (low < threshold) high = QCC_mulHigh(QCC_rngNext(rng), n, &low);
   }
-  *l = (random() % n) + _from;
+  return high;
 }
 
-void QCC_genLongAt(long *l) {
-  long from = QCC_LONG_FROM;
-  long to = QCC_LONG_TO;
-  QCC_genLongAtR(l, &from, &to);
+/* Version of QCC_rngBelow drawing 32 bits values */
+static uint32_t QCC_rngBelow32(QCC_Rng *rng, uint32_t n) {
+  uint64_t m;
+
+  if (n == 0) return 0;
+  m = (QCC_rngNext(rng) >> 32) * n;
+  if ((uint32_t) m < n) {
+    uint32_t threshold = -n % n;
+    while ((uint32_t) m < threshold) m = (QCC_rngNext(rng) >> 32) * n;
+  }
+  return (uint32_t) (m >> 32);
 }
 
-QCC_GenValue* QCC_genLongR(long from, long to) {
-  long *v = malloc(sizeof(long));
-  QCC_genLongAtR(v, &from, &to);
+void QCC_rngSplit(QCC_Rng *rng, QCC_Rng *child) {
+  static const uint64_t jump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                   0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+  uint64_t s[4] = { 0, 0, 0, 0 };
+  int i, b, j;
 
-  return QCC_initGenValue(v, 1, QCC_showLong, QCC_freeSimpleValue);
+  *child = *rng;
+  for (i=0; i<4; i++) {
+    for (b=0; b<64; b++) {
+      if (jump[i] & (1ULL << b))
+        for (j=0; j<4; j++) s[j] ^= rng->s[j];
+      QCC_rngNext(rng);
+    }
+  }
+  memcpy(rng->s, s, sizeof(s));
 }
 
-QCC_GenValue* QCC_genLong() {
-  return QCC_genLongR(QCC_LONG_FROM, QCC_LONG_TO);
+/*
+ * Seed of the idx-th case of a run: cases can be replayed on their own,
+ * e.g. to rebuild in the runner the arguments of a case run by a worker.
+ */
+static uint64_t QCC_caseSeed(uint64_t runSeed, uint64_t idx) {
+  uint64_t x = runSeed ^ (idx * 0xd1342543de82ef95ULL);
+  return QCC_splitMix64(&x);
 }
 
-static char* QCC_showInt(void *value, int len) {
-  return QCC_showSimpleValue(value, INT, 11, "%d");
+QCC_Rng* QCC_getRng() {
+  QCC_rngUsed = QCC_TRUE;
+  if (QCC_currentRng) return QCC_currentRng;
+  if (!QCC_threadRngSeeded) {
+    QCC_rngSeed(&QCC_threadRng, 1);
+    QCC_threadRngSeeded = 1;
+  }
+  return &QCC_threadRng;
 }
 
-void QCC_genIntAtR(int *i, int *from, int *to) {
-  int n = *to - *from;
-  *i = (int) (random() % n) + *from;
+QCC_Rng* QCC_setRng(QCC_Rng *rng) {
+  QCC_Rng *prev = QCC_currentRng;
+  QCC_currentRng = rng;
+  return prev;
 }
 
-void QCC_genIntAt(int *i) {
-  int from = QCC_INT_FROM;
-  int to = QCC_INT_TO;
-  QCC_genIntAtR(i, &from, &to);
+void QCC_init(int seed) {
+  QCC_rngSeed(&QCC_threadRng, seed ? (uint64_t) seed : (uint64_t) time(NULL));
+  QCC_threadRngSeeded = 1;
 }
 
-QCC_GenValue* QCC_genIntR(int from, int to) {
-  int *v = malloc(sizeof(int));
-  QCC_genIntAtR(v, &from, &to);
+/***********************************************************************
+ *  Edge cases
+ ***********************************************************************/
 
-  return QCC_initGenValue(v, 1, QCC_showInt, QCC_freeSimpleValue);
-}
+/*
+ * Generators replace a random value with one of their edge values with
+ * probability QCC_edgeThreshold / 2^64. The first QCC_edgePrefix cases of a
+ * run only draw edge values: the d-th value drawn by case c is the edge
+ * (c + d * (c / n)) % n of the n available, so the first n cases try each
+ * edge for all the arguments and the following ones pair them shifted by
+ * one, two, ... Runners identify prefix cases by their index in the
+ * prefix, -1 for the other cases.
+ */
+#define QCC_DEFAULT_EDGE_PROBABILITY 0.05
+#define QCC_DEFAULT_EDGE_PREFIX 16
 
-QCC_GenValue* QCC_genInt() {
-  return QCC_genIntR(QCC_INT_FROM, QCC_INT_TO);
-}
+static uint64_t QCC_edgeThreshold = (uint64_t) (QCC_DEFAULT_EDGE_PROBABILITY * 0x1.0p64);
+static int QCC_edgePrefix = QCC_DEFAULT_EDGE_PREFIX;
+static _Thread_local int QCC_currentEdge = -1;
+static _Thread_local int QCC_edgeDraws = 0;
+/* Enumeration in progress on the current thread, see QCC_choose */
+static _Thread_local struct QCC_Enumeration *QCC_currentEnum = NULL;
 
-static char* QCC_showDouble(void *value, int len) {
-  return QCC_showSimpleValue(value, DOUBLE, 50, "%.12e");
+void QCC_setEdgeCases(double probability, int prefix) {
+  QCC_edgeThreshold = probability > 0 ? (probability < 1 ? (uint64_t) (probability * 0x1.0p64) : UINT64_MAX) : 0;
+  QCC_edgePrefix = prefix > 0 ? prefix : 0;
 }
 
-void QCC_genDoubleAtR(double *d, double *from, double *to) {
-  double r = (double)random() / (double) RAND_MAX;
-  *d = *from + (*to - *from) * r;
+static int QCC_caseEdge(uint64_t caseIndex) {
+  return caseIndex < (uint64_t) QCC_edgePrefix ? (int) caseIndex : -1;
 }
 
-void QCC_genDoubleAt(double *d) {
-  double from = QCC_DOUBLE_FROM;
-  double to = QCC_DOUBLE_TO;
-  QCC_genDoubleAtR(d, &from, &to);
+static int QCC_setCurrentEdge(int edge) {
+  int prev = QCC_currentEdge;
+  QCC_currentEdge = edge;
+  return prev;
 }
 
-QCC_GenValue* QCC_genDoubleR(double from, double to) {
-  double *v = malloc(sizeof(double));
-  QCC_genDoubleAtR(v, &from, &to);
-  return QCC_initGenValue(v, 1, QCC_showDouble, QCC_freeSimpleValue);
+/*
+ * Whether the value being generated is an edge value. Generators only
+ * list their edges if it is, then pick one with QCC_rngEdgePick.
+ */
+static QCC_Boolean QCC_rngEdgeNext(QCC_Rng *rng) {
+  return QCC_currentEdge >= 0 || (QCC_edgeThreshold && QCC_rngNext(rng) < QCC_edgeThreshold);
 }
 
-QCC_GenValue* QCC_genDouble() {
-  return QCC_genDoubleR(QCC_DOUBLE_FROM, QCC_DOUBLE_TO);
-}
+static int QCC_rngEdgePick(QCC_Rng *rng, int n) {
+  int c = QCC_currentEdge;
 
-static char* QCC_showFloat(void *value, int len) {
-  return QCC_showSimpleValue(value, FLOAT, 50, "%.12e");
+  if (c >= 0) return (int) ((c + (int64_t) QCC_edgeDraws++ * (c / n)) % n);
+  return (int) QCC_rngBelow(rng, n);
 }
 
-void QCC_genFloatAtR(float *f, float *from, float *to) {
-  float r = (float)random() / (float) RAND_MAX;
-  *f = *from + (*to - *from) * r;
-}
+int QCC_edgeIndex(int n) {
+  QCC_Rng *rng;
 
-void QCC_genFloatAt(float *f) {
-  float from = QCC_FLOAT_FROM;
-  float to = QCC_FLOAT_TO;
-  QCC_genFloatAtR(f, &from, &to);
+  /* Enumerations go through the edge values anyway */
+  if (QCC_currentEnum) return -1;
+  rng = QCC_getRng();
+  return n > 0 && QCC_rngEdgeNext(rng) ? QCC_rngEdgePick(rng, n) : -1;
 }
 
-QCC_GenValue* QCC_genFloatR(float from, float to) {
-  float *v = malloc(sizeof(float));
-  QCC_genFloatAtR(v, &from, &to);
+/***********************************************************************
+ *  Enumeration
+ ***********************************************************************/
 
-  return QCC_initGenValue(v, 1, QCC_showFloat, QCC_freeSimpleValue);
-}
+/*
+ * Generators of finite domains make their choices through QCC_choose.
+ * While a runner enumerates a domain the choices of a tuple are not drawn
+ * but read from QCC_currentEnum: the first fixed ones were set by the
+ * runner, the following ones are 0. The sizes recorded with each choice
+ * tell the runner which choices can be incremented to reach the next
+ * tuple, and choices larger than bound are left out.
+ */
+typedef struct QCC_Enumeration {
+  uint64_t *choices;
+  uint64_t *sizes;
+  int n;
+  int fixed;
+  int cap;
+  uint64_t bound;
+  QCC_Boolean truncated;
+} QCC_Enumeration;
 
-QCC_GenValue* QCC_genFloat() {
-  return QCC_genFloatR(QCC_FLOAT_FROM, QCC_FLOAT_TO);
+static QCC_Boolean QCC_autoEnumerate = QCC_TRUE;
+
+void QCC_setAutoEnumerate(QCC_Boolean enabled) {
+  QCC_autoEnumerate = enabled;
 }
 
-static char* QCC_showBoolean(void *value, int len) {
-  QCC_Boolean *b = (QCC_Boolean *)value;
+uint64_t QCC_choose(uint64_t n) {
+  QCC_Enumeration *e = QCC_currentEnum;
+  uint64_t c;
 
-  if (*b) return strdup("TRUE");
-  else return strdup("FALSE");
+  if (!e) return QCC_rngBelow(QCC_getRng(), n);
+  if (n == 0) n = 1;
+  if (e->n == e->cap) {
+    e->cap = e->cap ? e->cap * 2 : 16;
+    e->choices = realloc(e->choices, sizeof(uint64_t) * e->cap);
+    e->sizes = realloc(e->sizes, sizeof(uint64_t) * e->cap);
+  }
+  c = e->n < e->fixed ? e->choices[e->n] : 0;
+  if (n - 1 > e->bound) e->truncated = QCC_TRUE;
+  e->choices[e->n] = c < n ? c : n - 1;
+  e->sizes[e->n] = n;
+  return e->choices[e->n++];
 }
 
-void QCC_genBooleanAt(QCC_Boolean *b) {
-  double r = (double)random() / (double) RAND_MAX;
-  *b = r > 0.5 ? QCC_TRUE : QCC_FALSE;
+/***********************************************************************
+ *  Generation size
+ ***********************************************************************/
+
+/*
+ * The size of a case bounds how big its generated values are, e.g. the
+ * length of arrays and strings. Runners derive it from the case index
+ * through the size curve, so a case is still identified by (run seed,
+ * case index). Outside of a run generators use the maximum size.
+ */
+#define QCC_DEFAULT_MAX_SIZE 100
+
+static int QCC_maxSize = QCC_DEFAULT_MAX_SIZE;
+static QCC_sizeCurve QCC_curve = QCC_sizeCycle;
+static _Thread_local int QCC_currentSize = -1;
+
+int QCC_sizeCycle(uint64_t caseIndex, int maxSize) {
+  return (int) (caseIndex % ((uint64_t) maxSize + 1));
 }
 
-QCC_GenValue* QCC_genBoolean() {
-  QCC_Boolean *v = malloc(sizeof(QCC_Boolean));
-  QCC_genBooleanAt(v);
+int QCC_sizeRamp(uint64_t caseIndex, int maxSize) {
+  return caseIndex < (uint64_t) maxSize ? (int) caseIndex : maxSize;
+}
 
-  return QCC_initGenValue(v, 1, QCC_showBoolean, QCC_freeSimpleValue);
+int QCC_sizeMax(uint64_t caseIndex, int maxSize) {
+  return maxSize;
 }
 
-static char* QCC_showChar(void *value, int len) {
-  return QCC_showSimpleValue(value, CHAR, 3, "'%c'");
+void QCC_setSize(int maxSize, QCC_sizeCurve curve) {
+  QCC_maxSize = maxSize > 0 ? maxSize : QCC_DEFAULT_MAX_SIZE;
+  QCC_curve = curve ? curve : QCC_sizeCycle;
 }
 
-void QCC_genCharAt(char *c) {
-  *c = (char) (random() % 93) + 33;
+int QCC_getSize() {
+  return QCC_currentSize >= 0 ? QCC_currentSize : QCC_maxSize;
 }
 
-QCC_GenValue* QCC_genChar() {
-  char *v = malloc(sizeof(char));
-  QCC_genCharAt(v);
+static int QCC_caseSize(uint64_t caseIndex) {
+  int size = QCC_curve(caseIndex, QCC_maxSize);
+  return size < 0 ? 0 : (size > QCC_maxSize ? QCC_maxSize : size);
+}
 
-  return QCC_initGenValue(v, 1, QCC_showChar, QCC_freeSimpleValue);
+static int QCC_setCurrentSize(int size) {
+  int prev = QCC_currentSize;
+  QCC_currentSize = size;
+  return prev;
 }
 
+/*
+ * Length of a generated array in [0, len): at the maximum size the whole
+ * range is used, smaller sizes shrink it proportionally. Edge lengths are
+ * 0, 1 and the longest one.
+ */
+static int QCC_rngLength(QCC_Rng *rng, int len) {
+  int size = QCC_getSize();
+  int edge;
+
+  if (size < QCC_maxSize) len = 1 + (int) ((int64_t) (len - 1) * size / QCC_maxSize);
+  if (QCC_rngEdgeNext(rng)) {
+    edge = QCC_rngEdgePick(rng, len < 3 ? len : 3);
+    return edge < 2 ? edge : len - 1;
+  }
+  return (int) (QCC_rngNext(rng) % len);
+}
 
 /***********************************************************************
- *  Array generators implementations
+ *  Bulk random generation
  ***********************************************************************/
 
-QCC_GenValue* QCC_genArrayOf(int len, QCC_genRaw elemGen, size_t elemSize, QCC_showValue show, QCC_freeValue free) {
-  int n = (int) random() % len;
-  uint8_t *arr = malloc(n*elemSize);
+/*
+ * Bulk fills run 4 interleaved xoshiro256** lanes seeded from the caller's
+ * generator: out[4*j+l] is the j-th output of lane l. State is stored word
+ * major (s[k][l] is word k of lane l) so that each state word of the 4
+ * lanes fits a single AVX2 register, or two SSE2 ones. The scalar, SSE2
+ * and AVX2 kernels produce exactly the same sequence, so generated values
+ * do not depend on the CPU running the tests.
+ * Short fills draw directly from the caller's generator since seeding the
+ * lanes would cost more than the fill itself.
+ */
+#define QCC_LANES 4
+#define QCC_LANES_MIN_WORDS 32
+#define QCC_FILL_BLOCK 256
+
+typedef struct QCC_RngLanes {
+  uint64_t s[4][QCC_LANES];
+} QCC_RngLanes;
+
+typedef void (*QCC_fillLanesKernel)(QCC_RngLanes *lanes, uint64_t *out, size_t groups);
+
+typedef struct QCC_RawSource {
+  QCC_Rng *rng;
+  QCC_RngLanes lanes;
+  QCC_fillLanesKernel kernel;
+} QCC_RawSource;
 
-  int p,i;
-  for(i=0, p=0; i<n; i++, p += elemSize) elemGen(arr+p);
+static void QCC_fillLanesScalar(QCC_RngLanes *lanes, uint64_t *out, size_t groups) {
+  uint64_t (*s)[QCC_LANES] = lanes->s;
+  size_t g;
+  int l;
 
-  return QCC_initGenValue(arr, n, show, free);
+  for (g=0; g<groups; g++) {
+    for (l=0; l<QCC_LANES; l++) {
+      uint64_t t = s[1][l] << 17;
+      out[g*QCC_LANES + l] = QCC_rotl(s[1][l] * 5, 7) * 9;
+      s[2][l] ^= s[0][l];
+      s[3][l] ^= s[1][l];
+      s[1][l] ^= s[2][l];
+      s[0][l] ^= s[3][l];
+      s[2][l] ^= t;
+      s[3][l] = QCC_rotl(s[3][l], 45);
+    }
+  }
 }
 
-QCC_GenValue* QCC_genArrayOfR(int len, QCC_genRawR elemGen, void *from, void *to, size_t elemSize, QCC_showValue show, QCC_freeValue free) {
-  int n = (int) random() % len;
-  uint8_t *arr = malloc(n*elemSize);
+#ifdef QCC_X86_SIMD
+__attribute__((target("sse2")))
+static void QCC_fillLanesSSE2(QCC_RngLanes *lanes, uint64_t *out, size_t groups) {
+  __m128i s[4][2];
+  size_t g;
+  int k, h;
+
+  for (k=0; k<4; k++)
+    for (h=0; h<2; h++) s[k][h] = _mm_loadu_si128((__m128i *) &lanes->s[k][2*h]);
+
+  for (g=0; g<groups; g++) {
+    for (h=0; h<2; h++) {
+      __m128i x = _mm_add_epi64(s[1][h], _mm_slli_epi64(s[1][h], 2));
+      x = _mm_or_si128(_mm_slli_epi64(x, 7), _mm_srli_epi64(x, 57));
+      x = _mm_add_epi64(x, _mm_slli_epi64(x, 3));
+      _mm_storeu_si128((__m128i *) &out[g*QCC_LANES + 2*h], x);
 
-  int p,i;
-  for(i=0, p=0; i<n; i++, p += elemSize) elemGen(arr+p, from, to);
+      __m128i t = _mm_slli_epi64(s[1][h], 17);
+      s[2][h] = _mm_xor_si128(s[2][h], s[0][h]);
+      s[3][h] = _mm_xor_si128(s[3][h], s[1][h]);
+      s[1][h] = _mm_xor_si128(s[1][h], s[2][h]);
+      s[0][h] = _mm_xor_si128(s[0][h], s[3][h]);
+      s[2][h] = _mm_xor_si128(s[2][h], t);
+      s[3][h] = _mm_or_si128(_mm_slli_epi64(s[3][h], 45), _mm_srli_epi64(s[3][h], 19));
+    }
+  }
 
-  return QCC_initGenValue(arr, n, show, free);
+  for (k=0; k<4; k++)
+    for (h=0; h<2; h++) _mm_storeu_si128((__m128i *) &lanes->s[k][2*h], s[k][h]);
 }
 
-static char *QCC_showString(void *value, int len) {
-  return QCC_showSimpleValue(value, NONE, len, "%s");
+__attribute__((target("avx2")))
+static void QCC_fillLanesAVX2(QCC_RngLanes *lanes, uint64_t *out, size_t groups) {
+  __m256i s0 = _mm256_loadu_si256((__m256i *) lanes->s[0]);
+  __m256i s1 = _mm256_loadu_si256((__m256i *) lanes->s[1]);
+  __m256i s2 = _mm256_loadu_si256((__m256i *) lanes->s[2]);
+  __m256i s3 = _mm256_loadu_si256((__m256i *) lanes->s[3]);
+  size_t g;
+
+  for (g=0; g<groups; g++) {
+    __m256i x = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+    x = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+    x = _mm256_add_epi64(x, _mm256_slli_epi64(x, 3));
+    _mm256_storeu_si256((__m256i *) &out[g*QCC_LANES], x);
+
+    __m256i t = _mm256_slli_epi64(s1, 17);
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+  }
+
+  _mm256_storeu_si256((__m256i *) lanes->s[0], s0);
+  _mm256_storeu_si256((__m256i *) lanes->s[1], s1);
+  _mm256_storeu_si256((__m256i *) lanes->s[2], s2);
+  _mm256_storeu_si256((__m256i *) lanes->s[3], s3);
 }
+#endif
 
-QCC_GenValue* QCC_genStringL(int len) {
-  QCC_GenValue *s = QCC_genArrayOf(len, (QCC_genRaw) QCC_genCharAt, sizeof(char), QCC_showString, QCC_freeSimpleValue);
-  ((char *)s->value)[s->n-1] = '\0';
-  return s;
+static QCC_fillLanesKernel QCC_selectLanesKernel() {
+#ifdef QCC_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) return QCC_fillLanesAVX2;
+  if (__builtin_cpu_supports("sse2")) return QCC_fillLanesSSE2;
+#endif
+  return QCC_fillLanesScalar;
 }
 
-QCC_GenValue* QCC_genString() {
-  return QCC_genStringL(50);
+static void QCC_rawBegin(QCC_RawSource *src, QCC_Rng *rng, size_t words) {
+  int k, l;
+
+  src->rng = rng;
+  src->kernel = NULL;
+  if (words < QCC_LANES_MIN_WORDS) return;
+
+  for (l=0; l<QCC_LANES; l++) {
+    QCC_Rng lane;
+    QCC_rngSeed(&lane, QCC_rngNext(rng));
+    for (k=0; k<4; k++) src->lanes.s[k][l] = lane.s[k];
+  }
+  src->kernel = QCC_selectLanesKernel();
 }
 
-static char *QCC_showSimpleArray(void *value, size_t elemSize, QCC_showValue showValue, int len) {
-  char **valStr = malloc(sizeof(char *) * len);
-  int valStrLen = 0;
-  int i;
-  for (i=0; i<len; i++) {
-    valStr[i] = showValue(((uint8_t *)value) + (i*elemSize), 1);
-    valStrLen += strlen(valStr[i]);
+static void QCC_rawNext(QCC_RawSource *src, uint64_t *out, size_t n) {
+  size_t i;
+
+  if (!src->kernel) {
+    for (i=0; i<n; i++) out[i] = QCC_rngNext(src->rng);
+    return;
   }
 
-  int totStrLen = valStrLen + 2 + 2*len + 1;
-  char *str = malloc(sizeof(char) * totStrLen);
-  sprintf(str, "[");
-  int currLen = 1;
-  for (i=0; i<len; i++) {
-    if (i==0) {
-      sprintf(str + currLen, "%s", valStr[i]);
-    } else {
-      sprintf(str + currLen, ", %s", valStr[i]);
-      currLen += 2;
-    }
-    currLen += strlen(valStr[i]);
-    free(valStr[i]);
+  src->kernel(&src->lanes, out, n / QCC_LANES);
+  if (n % QCC_LANES) {
+    uint64_t tail[QCC_LANES];
+    src->kernel(&src->lanes, tail, 1);
+    memcpy(out + n - n % QCC_LANES, tail, (n % QCC_LANES) * sizeof(uint64_t));
   }
-  sprintf(str + currLen, "]");
-  free(valStr);
-  return str;
 }
 
-static char* QCC_showArrayLong(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(long), QCC_showLong, n);
+void QCC_rngFill(QCC_Rng *rng, uint64_t *out, size_t n) {
+  QCC_RawSource src;
+  QCC_rawBegin(&src, rng, n);
+  QCC_rawNext(&src, out, n);
 }
 
-QCC_GenValue* QCC_genArrayLongLR(int len, long from, long to) {
-  return QCC_genArrayOfR(len, (QCC_genRawR) QCC_genLongAtR, &from, &to, sizeof(long), QCC_showArrayLong, QCC_freeSimpleValue);
-}
+/*
+ * Typed fills map blocks of raw words with branch free multiply-shift
+ * reductions, which the compiler is free to vectorize. Ranged fills map
+ * each raw value as QCC_rngBelow does: the rejection threshold is computed
+ * once per fill, and the rare rejected values are replaced with values
+ * drawn from rng.
+ */
+void QCC_rngFillLongR(QCC_Rng *rng, long *buf, int n, long *from, long *to) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  uint64_t range = (unsigned long) *to - (unsigned long) *from;
+  uint64_t threshold, low, r;
+  QCC_RawSource src;
+  int i, j, m;
 
-QCC_GenValue* QCC_genArrayLongL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genLongAt, sizeof(long), QCC_showArrayLong, QCC_freeSimpleValue);
+  if (range == 0) {
+    for (i=0; i<n; i++) buf[i] = *from;
+    return;
+  }
+  threshold = -range % range;
+  QCC_rawBegin(&src, rng, n);
+  for (i=0; i<n; i+=m) {
+    m = n - i < QCC_FILL_BLOCK ? n - i : QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, m);
+    for (j=0; j<m; j++) {
+      r = QCC_mulHigh(raw[j], range, &low);
+      if (low < threshold) r = QCC_rngBelow(rng, range);
+      buf[i+j] = (long) ((unsigned long) *from + r);
+    }
+  }
 }
 
-QCC_GenValue* QCC_genArrayLong() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genLongAt, sizeof(long), QCC_showArrayLong, QCC_freeSimpleValue);
-}
+void QCC_rngFillIntR(QCC_Rng *rng, int *buf, int n, int *from, int *to) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  uint32_t range = (uint32_t) *to - (uint32_t) *from;
+  uint32_t threshold;
+  QCC_RawSource src;
+  int i, j, m;
 
-static char* QCC_showArrayInt(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(int), QCC_showInt, n);
+  if (range == 0) {
+    for (i=0; i<n; i++) buf[i] = *from;
+    return;
+  }
+  threshold = -range % range;
+  QCC_rawBegin(&src, rng, (n+1)/2);
+  for (i=0; i<n; i+=m) {
+    m = n - i < 2*QCC_FILL_BLOCK ? n - i : 2*QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, (m+1)/2);
+    for (j=0; j<m; j++) {
+      uint64_t r = ((raw[j/2] >> (32 * (j%2))) & 0xffffffffULL) * range;
+      if ((uint32_t) r < threshold) r = (uint64_t) QCC_rngBelow32(rng, range) << 32;
+      buf[i+j] = (int) ((uint32_t) *from + (uint32_t) (r >> 32));
+    }
+  }
 }
 
-QCC_GenValue* QCC_genArrayIntLR(int len, int from, int to) {
-  return QCC_genArrayOfR(len, (QCC_genRawR) QCC_genIntAtR, &from, &to, sizeof(int), QCC_showArrayInt, QCC_freeSimpleValue);
-}
+void QCC_rngFillDoubleR(QCC_Rng *rng, double *buf, int n, double *from, double *to) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  double range = *to - *from;
+  QCC_RawSource src;
+  int i, j, m;
 
-QCC_GenValue* QCC_genArrayIntL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genIntAt, sizeof(int), QCC_showArrayInt, QCC_freeSimpleValue);
+  QCC_rawBegin(&src, rng, n);
+  for (i=0; i<n; i+=m) {
+    m = n - i < QCC_FILL_BLOCK ? n - i : QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, m);
+    for (j=0; j<m; j++)
+      buf[i+j] = *from + range * ((double) (raw[j] >> 11) * 0x1.0p-53);
+  }
 }
 
-QCC_GenValue* QCC_genArrayInt() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genIntAt, sizeof(int), QCC_showArrayInt, QCC_freeSimpleValue);
-}
+void QCC_rngFillFloatR(QCC_Rng *rng, float *buf, int n, float *from, float *to) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  float range = *to - *from;
+  QCC_RawSource src;
+  int i, j, m;
 
-static char* QCC_showArrayDouble(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(double), QCC_showDouble, n);
+  QCC_rawBegin(&src, rng, (n+1)/2);
+  for (i=0; i<n; i+=m) {
+    m = n - i < 2*QCC_FILL_BLOCK ? n - i : 2*QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, (m+1)/2);
+    for (j=0; j<m; j++) {
+      uint32_t r = (uint32_t) (raw[j/2] >> (32 * (j%2))) >> 8;
+      buf[i+j] = *from + range * ((float) r * 0x1.0p-24f);
+    }
+  }
 }
 
-QCC_GenValue* QCC_genArrayDoubleLR(int len, double from, double to) {
-  return QCC_genArrayOfR(len, (QCC_genRawR) QCC_genDoubleAtR, &from, &to, sizeof(double), QCC_showArrayDouble, QCC_freeSimpleValue);
-}
+void QCC_rngFillBoolean(QCC_Rng *rng, QCC_Boolean *buf, int n) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  QCC_RawSource src;
+  int i, j, m;
 
-QCC_GenValue* QCC_genArrayDoubleL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genDoubleAt, sizeof(double), QCC_showArrayDouble, QCC_freeSimpleValue);
+  QCC_rawBegin(&src, rng, (n+63)/64);
+  for (i=0; i<n; i+=m) {
+    m = n - i < 64*QCC_FILL_BLOCK ? n - i : 64*QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, (m+63)/64);
+    for (j=0; j<m; j++)
+      buf[i+j] = ((raw[j/64] >> (j%64)) & 1) ? QCC_TRUE : QCC_FALSE;
+  }
 }
 
-QCC_GenValue* QCC_genArrayDouble() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genDoubleAt, sizeof(double), QCC_showArrayDouble, QCC_freeSimpleValue);
-}
+/* Printable characters in [33, 126) as QCC_rngCharAt */
+void QCC_rngFillChar(QCC_Rng *rng, char *buf, int n) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  QCC_RawSource src;
+  int i, j, m;
 
-static char* QCC_showArrayFloat(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(float), QCC_showFloat, n);
+  QCC_rawBegin(&src, rng, (n+3)/4);
+  for (i=0; i<n; i+=m) {
+    m = n - i < 4*QCC_FILL_BLOCK ? n - i : 4*QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, (m+3)/4);
+    for (j=0; j<m; j++) {
+      uint32_t r = (uint32_t) (raw[j/4] >> (16 * (j%4))) & 0xffff;
+      buf[i+j] = (char) (33 + ((r * 93) >> 16));
+    }
+  }
 }
 
-QCC_GenValue* QCC_genArrayFloatLR(int len, float from, float to) {
-  return QCC_genArrayOfR(len, (QCC_genRawR) QCC_genFloatAtR, &from, &to, sizeof(float), QCC_showArrayFloat, QCC_freeSimpleValue);
-}
+/* Fills of the whole range of the integer types, with raw values */
+static void QCC_rngFillLong(QCC_Rng *rng, long *buf, int n) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  QCC_RawSource src;
+  int i, j, m;
 
-QCC_GenValue* QCC_genArrayFloatL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genFloatAt, sizeof(float), QCC_showArrayFloat, QCC_freeSimpleValue);
+  QCC_rawBegin(&src, rng, n);
+  for (i=0; i<n; i+=m) {
+    m = n - i < QCC_FILL_BLOCK ? n - i : QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, m);
+    for (j=0; j<m; j++) buf[i+j] = (long) (unsigned long) raw[j];
+  }
 }
 
-QCC_GenValue* QCC_genArrayFloat() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genFloatAt, sizeof(float), QCC_showArrayFloat, QCC_freeSimpleValue);
+static void QCC_rngFillInt(QCC_Rng *rng, int *buf, int n) {
+  uint64_t raw[QCC_FILL_BLOCK];
+  QCC_RawSource src;
+  int i, j, m;
+
+  QCC_rawBegin(&src, rng, (n+1)/2);
+  for (i=0; i<n; i+=m) {
+    m = n - i < 2*QCC_FILL_BLOCK ? n - i : 2*QCC_FILL_BLOCK;
+    QCC_rawNext(&src, raw, (m+1)/2);
+    for (j=0; j<m; j++) buf[i+j] = (int) (uint32_t) (raw[j/2] >> (32 * (j%2)));
+  }
 }
 
-static char* QCC_showArrayBoolean(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(QCC_Boolean), QCC_showBoolean, n);
+/*
+ * Fills of untyped buffers as QCC_fillRaw and QCC_fillRawR, converting the
+ * bounds to the element type, for array and column generators. Integer
+ * bounds are both included (see QCC_shrinkTarget): to + 1 wraps around to
+ * from when they span the whole type.
+ */
+static void QCC_fillLongR(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  long f = *(const long *) from, t = (long) (*(const unsigned long *) to + 1);
+  if (t != f) QCC_rngFillLongR(rng, buf, n, &f, &t);
+  else QCC_rngFillLong(rng, buf, n);
 }
 
-QCC_GenValue* QCC_genArrayBooleanL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genBooleanAt, sizeof(QCC_Boolean), QCC_showArrayBoolean, QCC_freeSimpleValue);
+static void QCC_fillIntR(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  int f = *(const int *) from, t = (int) (*(const unsigned int *) to + 1);
+  if (t != f) QCC_rngFillIntR(rng, buf, n, &f, &t);
+  else QCC_rngFillInt(rng, buf, n);
 }
 
-QCC_GenValue* QCC_genArrayBoolean() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genBooleanAt, sizeof(QCC_Boolean), QCC_showArrayBoolean, QCC_freeSimpleValue);
+static void QCC_fillDoubleR(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  double f = *(const double *) from, t = *(const double *) to;
+  QCC_rngFillDoubleR(rng, buf, n, &f, &t);
 }
 
-static char* QCC_showArrayChar(void *value, int n) {
-  return QCC_showSimpleArray(value, sizeof(char), QCC_showChar, n);
+static void QCC_fillFloatR(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  float f = *(const float *) from, t = *(const float *) to;
+  QCC_rngFillFloatR(rng, buf, n, &f, &t);
 }
 
-QCC_GenValue* QCC_genArrayCharL(int len) {
-  return QCC_genArrayOf(len, (QCC_genRaw) QCC_genCharAt, sizeof(char), QCC_showArrayChar, QCC_freeSimpleValue);
+static void QCC_fillBoolean(QCC_Rng *rng, void *buf, int n) {
+  QCC_rngFillBoolean(rng, buf, n);
 }
 
-QCC_GenValue* QCC_genArrayChar() {
-  return QCC_genArrayOf(50, (QCC_genRaw) QCC_genCharAt, sizeof(char), QCC_showArrayChar, QCC_freeSimpleValue);
+static void QCC_fillChar(QCC_Rng *rng, void *buf, int n) {
+  QCC_rngFillChar(rng, buf, n);
 }
 
 /***********************************************************************
- *  Convenience functions
+ *  Arena allocation
  ***********************************************************************/
-QCC_TestStatus QCC_not(QCC_TestStatus propStatus) {
-  switch (propStatus) {
-  case QCC_OK: return QCC_FAIL;
-  case QCC_FAIL: return QCC_OK;
-  case QCC_NOTHING: return QCC_NOTHING;
-  default: return QCC_FAIL;
-  }
+
+/*
+ * A runner using an arena installs it on the thread evaluating the cases
+ * and resets it before each case, so that all the memory obtained through
+ * QCC_alloc while generating (and shrinking) a case is released at once.
+ */
+#define QCC_ARENA_ALIGN 16
+
+typedef struct QCC_ArenaChunk {
+  struct QCC_ArenaChunk *next;
+  size_t size;
+  size_t used;
+  _Alignas(QCC_ARENA_ALIGN) uint8_t data[];
+} QCC_ArenaChunk;
+
+typedef struct QCC_Arena {
+  QCC_ArenaChunk *chunks;
+  QCC_ArenaChunk *current;
+  size_t chunkSize;
+} QCC_Arena;
+
+static size_t QCC_arenaChunkSize = 0;
+static _Thread_local QCC_Arena *QCC_currentArena = NULL;
+
+void QCC_setArena(size_t chunkSize) {
+  QCC_arenaChunkSize = chunkSize;
 }
 
-QCC_TestStatus QCC_and(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
-  switch (prop1Status) {
-  case QCC_OK: return prop2Status;
-  case QCC_FAIL: return QCC_FAIL;
-  case QCC_NOTHING: return QCC_NOTHING;
-  default: return QCC_FAIL;
-  }
+static QCC_Arena* QCC_newArena() {
+  if (!QCC_arenaChunkSize) return NULL;
+
+  QCC_Arena *arena = malloc(sizeof(QCC_Arena));
+  *arena = (QCC_Arena) { .chunks=NULL, .current=NULL, .chunkSize=QCC_arenaChunkSize };
+  return arena;
 }
 
-QCC_TestStatus QCC_or(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
-  switch (prop1Status) {
-  case QCC_OK: return QCC_OK;
-  case QCC_FAIL:
-  case QCC_NOTHING:
-    return prop2Status;
-  default: return QCC_FAIL;
+static void QCC_freeArena(QCC_Arena *arena) {
+  if (!arena) return;
+
+  QCC_ArenaChunk *chunk = arena->chunks;
+  while (chunk) {
+    QCC_ArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
   }
+  free(arena);
 }
 
-QCC_TestStatus QCC_xor(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
-  switch (prop1Status) {
-  case QCC_OK: return QCC_not(prop2Status);
-  case QCC_FAIL: return prop2Status;
-  case QCC_NOTHING: return QCC_NOTHING;
-  default: return QCC_FAIL;
-  }
+static void QCC_resetArena(QCC_Arena *arena) {
+  if (!arena || !arena->chunks) return;
+  arena->current = arena->chunks;
+  arena->current->used = 0;
 }
 
-/***********************************************************************
- *  Categorization function
- ***********************************************************************/
-void QCC_freeStamp(QCC_Stamp *stamps) {
-  QCC_Stamp *tstamps;
-  QCC_Stamp *curr;
-  for (tstamps=stamps; tstamps != NULL;) {
-    curr = tstamps;
-    tstamps = tstamps->next;
-    free(curr->label);
-    free(curr);
-  }
+static QCC_Arena* QCC_useArena(QCC_Arena *arena) {
+  QCC_Arena *prev = QCC_currentArena;
+  QCC_currentArena = arena;
+  return prev;
 }
 
-static void QCC_insertOrdStamp(QCC_Stamp **stamps, QCC_Stamp *s) {
-  QCC_Stamp *new = malloc(sizeof(QCC_Stamp));
-  *new = (QCC_Stamp) { .label = strdup(s->label), .n=s->n, .next = NULL };
+static void* QCC_arenaAlloc(QCC_Arena *arena, size_t size) {
+  QCC_ArenaChunk *chunk = arena->current;
+  size = (size + QCC_ARENA_ALIGN - 1) & ~((size_t) QCC_ARENA_ALIGN - 1);
 
-  QCC_Stamp *tstamp = *stamps;
-  QCC_Stamp **pre = stamps;
-  while (tstamp) {
-    if (tstamp->n < new->n) {
-      break;
+  /* Chunks following the current one are left over from previous cases */
+  while (chunk && chunk->used + size > chunk->size) {
+    chunk = chunk->next;
+    if (chunk) chunk->used = 0;
+  }
+
+  if (!chunk) {
+    size_t chunkSize = size > arena->chunkSize ? size : arena->chunkSize;
+    chunk = malloc(sizeof(QCC_ArenaChunk) + chunkSize);
+    *chunk = (QCC_ArenaChunk) { .next=NULL, .size=chunkSize, .used=0 };
+    if (arena->current) {
+      chunk->next = arena->current->next;
+      arena->current->next = chunk;
     } else {
-      pre = &tstamp->next;
-      tstamp = tstamp->next;
+      arena->chunks = chunk;
     }
   }
-  *pre = new;
-  new->next = tstamp;
+
+  arena->current = chunk;
+  void *ptr = chunk->data + chunk->used;
+  chunk->used += size;
+  return ptr;
 }
 
-static QCC_Stamp* QCC_sortStamp(QCC_Stamp *stamps) {
-  QCC_Stamp *sortedStamps = NULL;
-  QCC_Stamp *tstamp;
-  for (tstamp=stamps; tstamp!=NULL; tstamp=tstamp->next) {
-    QCC_insertOrdStamp(&sortedStamps, tstamp);
-  }
-  return sortedStamps;
+void* QCC_alloc(size_t size) {
+  if (QCC_currentArena) return QCC_arenaAlloc(QCC_currentArena, size);
+  return malloc(size);
 }
 
-static void QCC_labelN(QCC_Stamp **stamps, char *label, int n) {
-  QCC_Stamp *ptr = *stamps;
-  QCC_Stamp *pre = NULL;
-  QCC_Stamp *new;
+/* Whether ptr was bump-allocated from one of the chunks of the arena */
+static QCC_Boolean QCC_arenaOwns(QCC_Arena *arena, void *ptr) {
+  QCC_ArenaChunk *chunk;
 
-  while(ptr) {
-    if (strcmp(ptr->label, label) == 0) {
-      (ptr->n)++;
-      return;
-    }
-    pre = ptr;
-    ptr = ptr->next;
-  }
+  for (chunk=arena->chunks; chunk; chunk=chunk->next)
+    if ((uintptr_t) ptr - (uintptr_t) chunk->data < chunk->size) return QCC_TRUE;
+  return QCC_FALSE;
+}
+
+void QCC_freeAlloc(void *value) {
+  if (!QCC_currentArena || !QCC_arenaOwns(QCC_currentArena, value)) free(value);
+}
 
-  new = malloc(sizeof(QCC_Stamp));
-  *new = (QCC_Stamp) { .label = strdup(label), .n=1, .next = NULL };
+/***********************************************************************
+ *  Sinks
+ ***********************************************************************/
+static int QCC_showMaxElems = 0;
 
-  if (pre) pre->next = new;
-  else *stamps = new;
+void QCC_setShowLimit(int maxElems) {
+  QCC_showMaxElems = maxElems > 0 ? maxElems : 0;
 }
 
-void QCC_label(QCC_Stamp **stamps, char *label) {
-  return QCC_labelN(stamps, label, 1);
+void QCC_initBufferSink(QCC_Sink *sink, char *buf, size_t cap) {
+  if (!buf || cap == 0) {
+    cap = cap ? cap : 64;
+    buf = realloc(buf, cap);
+  }
+  *sink = (QCC_Sink) { .buf=buf, .len=0, .cap=cap, .file=NULL, .maxElems=0 };
+  buf[0] = '\0';
 }
 
-static void QCC_mergeLabels(QCC_Stamp **dst, QCC_Stamp *src) {
-  for (; src != NULL; src=src->next)
-    QCC_labelN(dst, src->label, src->n);
+void QCC_initFileSink(QCC_Sink *sink, FILE *file) {
+  *sink = (QCC_Sink) { .buf=NULL, .len=0, .cap=0, .file=file, .maxElems=0 };
 }
 
-/***********************************************************************
- *  Testing functions
- ***********************************************************************/
-void QCC_freeGenValues(QCC_GenValue **arguments, int argumentsN) {
-  int i;
-  for (i=0; i<argumentsN; i++) {
-    arguments[i]->free(arguments[i]->value);
-    free(arguments[i]);
-  }
-  if (arguments) free(arguments);
+void QCC_freeSink(QCC_Sink *sink) {
+  free(sink->buf);
+  sink->buf = NULL;
+  sink->len = sink->cap = 0;
 }
 
-void QCC_freeResult(QCC_Result *res) {
-  QCC_freeStamp(res->stamps);
-  QCC_freeGenValues(res->arguments, res->argumentsN);
+/* Make room for n more characters plus the terminator */
+static void QCC_reserveSink(QCC_Sink *sink, size_t n) {
+  if (sink->len + n < sink->cap) return;
+  while (sink->len + n >= sink->cap) sink->cap *= 2;
+  sink->buf = realloc(sink->buf, sink->cap);
 }
 
-QCC_Result QCC_vforAll(QCC_property prop, int genNum, va_list genP) { //QCC_gen *genLst,
-  QCC_GenValue **vals = NULL;
-  if (genNum) {
-    int i;
-    vals = malloc(sizeof(QCC_GenValue*) * genNum);
-    for (i=0; i<genNum; i++) {
-      QCC_gen gen = va_arg(genP, QCC_gen);
-      vals[i] = gen();
-    }
+void QCC_sinkWrite(QCC_Sink *sink, const char *s, size_t n) {
+  if (sink->file) {
+    fwrite(s, 1, n, sink->file);
+    return;
   }
-
-  QCC_Stamp *stamps = NULL;
-  QCC_TestStatus status = prop(vals, genNum, &stamps);
-  return (QCC_Result) {
-    .status = status,
-      .stamps = stamps,
-      .arguments = vals,
-      .argumentsN = genNum
-      };
+  QCC_reserveSink(sink, n);
+  memcpy(sink->buf + sink->len, s, n);
+  sink->len += n;
+  sink->buf[sink->len] = '\0';
 }
 
-QCC_Result QCC_forAll(QCC_property prop, int genNum, ...) { //QCC_gen *genLst,
-  va_list genP;
-  QCC_Result res;
+static void QCC_vsinkPrintf(QCC_Sink *sink, const char *format, va_list ap) {
+  va_list retry;
+  int n;
+
+  if (sink->file) {
+    vfprintf(sink->file, format, ap);
+    return;
+  }
+  va_copy(retry, ap);
+  n = vsnprintf(sink->buf + sink->len, sink->cap - sink->len, format, ap);
+  if (n >= 0 && sink->len + n >= sink->cap) {
+    QCC_reserveSink(sink, n);
+    vsnprintf(sink->buf + sink->len, sink->cap - sink->len, format, retry);
+  }
+  va_end(retry);
+  if (n >= 0) sink->len += n;
+}
+
+void QCC_sinkPrintf(QCC_Sink *sink, const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  QCC_vsinkPrintf(sink, format, ap);
+  va_end(ap);
+}
+
+/*
+ * Reports of the runs go to the sink installed on the current thread, or
+ * to stdout, so that runs in concurrent threads can keep them apart.
+ */
+static _Thread_local QCC_Sink *QCC_reportSink = NULL;
+
+static QCC_Sink* QCC_setReportSink(QCC_Sink *sink) {
+  QCC_Sink *prev = QCC_reportSink;
+  QCC_reportSink = sink;
+  return prev;
+}
+
+static void QCC_reportf(const char *format, ...) {
+  QCC_Sink stdoutSink;
+  va_list ap;
+
+  if (!QCC_reportSink) QCC_initFileSink(&stdoutSink, stdout);
+  va_start(ap, format);
+  QCC_vsinkPrintf(QCC_reportSink ? QCC_reportSink : &stdoutSink, format, ap);
+  va_end(ap);
+}
+
+void QCC_writeGenValue(QCC_Sink *sink, QCC_GenValue *value) {
+  if (value->write) {
+    value->write(sink, value->value, value->n);
+  } else {
+    char *s = value->show(value->value, value->n);
+    QCC_sinkWrite(sink, s, strlen(s));
+    free(s);
+  }
+}
+
+/***********************************************************************
+ *  Generators helper functions
+ ***********************************************************************/
+static void QCC_writeSimpleValue(QCC_Sink *sink, void *value, enum QCC_deref_type dt, const char *format) {
+  switch (dt) {
+  case LONG:
+    QCC_sinkPrintf(sink, format, *(long*)value);
+    break;
+  case INT:
+    QCC_sinkPrintf(sink, format, *(int*)value);
+    break;
+  case FLOAT:
+    QCC_sinkPrintf(sink, format, *(float*)value);
+    break;
+  case DOUBLE:
+    QCC_sinkPrintf(sink, format, *(double*)value);
+    break;
+  case CHAR:
+    QCC_sinkPrintf(sink, format, *(char*)value);
+    break;
+  case NONE:
+    QCC_sinkPrintf(sink, format, (char*)value);
+    break;
+  default:
+    QCC_sinkPrintf(sink, format, *(int*)value);
+    break;
+  }
+}
+
+/* Integers are the bulk of large counterexamples: format them by hand */
+static void QCC_writeDigits(QCC_Sink *sink, uint64_t u, QCC_Boolean negative) {
+  char digits[24];
+  char *p = digits + sizeof(digits);
+
+  do {
+    *--p = '0' + (u % 10);
+    u /= 10;
+  } while (u);
+  if (negative) *--p = '-';
+  QCC_sinkWrite(sink, p, digits + sizeof(digits) - p);
+}
+
+static void QCC_writeDecimal(QCC_Sink *sink, long v) {
+  QCC_writeDigits(sink, v < 0 ? -(uint64_t) v : (uint64_t) v, v < 0);
+}
+
+/* Show a value through its write function */
+static char* QCC_showWritten(QCC_writeValue write, void *value, int len) {
+  QCC_Sink sink;
+  QCC_initBufferSink(&sink, NULL, 0);
+  write(&sink, value, len);
+  return sink.buf;
+}
+
+/*
+ * Values are hashed to detect repeated cases (see QCC_setDedup). Built-in
+ * values hash their bytes, which the element size picks a function for;
+ * values without a hash function hash their written form.
+ */
+static inline uint64_t QCC_hashMix(uint64_t h, uint64_t w) {
+  h = (h ^ w) * 0xff51afd7ed558ccdULL;
+  return h ^ (h >> 32);
+}
+
+static uint64_t QCC_hashBytes(const void *bytes, size_t n) {
+  const uint8_t *b = bytes;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ n, w;
+
+  for (; n >= 8; n -= 8, b += 8) {
+    memcpy(&w, b, 8);
+    h = QCC_hashMix(h, w);
+  }
+  if (n) {
+    w = 0;
+    memcpy(&w, b, n);
+    h = QCC_hashMix(h, w);
+  }
+  return QCC_splitMix64(&h);
+}
+
+#define QCC_HASH_ELEMS(size)                                      \
+static uint64_t QCC_hashElems##size(void *value, int len) {       \
+  return QCC_hashBytes(value, (size_t) len * size);               \
+}
+
+QCC_HASH_ELEMS(1)
+QCC_HASH_ELEMS(2)
+QCC_HASH_ELEMS(4)
+QCC_HASH_ELEMS(8)
+QCC_HASH_ELEMS(16)
+
+/* Hash of arrays of elemSize bytes elements, NULL for unusual sizes */
+static inline QCC_hashValue QCC_elemsHash(size_t elemSize) {
+  switch (elemSize) {
+  case 1: return QCC_hashElems1;
+  case 2: return QCC_hashElems2;
+  case 4: return QCC_hashElems4;
+  case 8: return QCC_hashElems8;
+  case 16: return QCC_hashElems16;
+  default: return NULL;
+  }
+}
+
+static uint64_t QCC_hashGenValue(QCC_GenValue *value) {
+  QCC_Sink sink;
+  uint64_t h;
+
+  if (value->hash) return value->hash(value->value, value->n);
+  QCC_initBufferSink(&sink, NULL, 64);
+  QCC_writeGenValue(&sink, value);
+  h = QCC_hashBytes(sink.buf, sink.len);
+  QCC_freeSink(&sink);
+  return h;
+}
+
+QCC_GenValue* QCC_initGenValue(void *value, int n, QCC_showValue show, QCC_freeValue free) {
+  QCC_GenValue *gv = QCC_alloc(sizeof(QCC_GenValue));
+  *gv = (QCC_GenValue) { .value=value, .n=n, .show=show, .free=free, .shrink=NULL, .write=NULL, .hash=NULL,
+                         .mutate=NULL };
+
+  return gv;
+}
+
+static QCC_GenValue* QCC_initShrinkableValue(void *value, int n, QCC_showValue show, QCC_writeValue write, QCC_freeValue free, QCC_shrinkValue shrink, QCC_mutateValue mutate, QCC_hashValue hash) {
+  QCC_GenValue *gv = QCC_initGenValue(value, n, show, free);
+  gv->write = write;
+  gv->shrink = shrink;
+  gv->hash = hash;
+  gv->mutate = mutate;
+  return gv;
+}
+
+/*
+ * Shrinking helpers.
+ * Built-in generators of numeric values store their range right after the
+ * generated value(s), so that shrink candidates never leave the range the
+ * value was generated in: [first, last] for integers, so that unranged
+ * values can hold both extremes of their type, and [from, to) for floating
+ * point values. Numbers shrink towards 0 (or the range bound closest to
+ * it): first the target itself, then values approaching the original one
+ * by halving the distance.
+ */
+static long QCC_shrinkTarget(long first, long last) {
+  if (first <= 0 && 0 <= last) return 0;
+  return first > 0 ? first : last;
+}
+
+/*
+ * Shrink candidates of integers work on their bits mapped to an unsigned
+ * order: signed values have their sign bit flipped, so that any integer
+ * type fits.
+ */
+#define QCC_SIGN_BIT 0x8000000000000000ULL
+#define QCC_SIGNED_BITS(v) ((uint64_t) (int64_t) (v) ^ QCC_SIGN_BIT)
+#define QCC_UNSIGNED_BITS(v) ((uint64_t) (v))
+
+static int QCC_shrinkOrdered(uint64_t v, uint64_t target, int idx, uint64_t *out) {
+  uint64_t d;
+
+  if (v == target) return 0;
+  if (idx == 0) {
+    *out = target;
+    return 1;
+  }
+  if (idx >= 64) return 0;
+
+  d = (v > target ? v - target : target - v) >> idx;
+  if (d == 0) return 0;
+  *out = v > target ? v - d : v + d;
+  return 1;
+}
+
+/*
+ * Choose one of the integers in [first, last], as ordered bits, while
+ * enumerating: the ones closest to the shrink target come first,
+ * alternating above and below it, so that small depths try small values.
+ */
+static uint64_t QCC_chooseOrdered(uint64_t first, uint64_t last, uint64_t zero) {
+  uint64_t target = first > zero ? first : (last < zero ? last : zero);
+  uint64_t up = last - target, down = target - first, m = up < down ? up : down;
+  uint64_t n = last - first + 1;
+  uint64_t k = QCC_choose(n ? n : UINT64_MAX);
+
+  if (k == 0) return target;
+  if ((k + 1) / 2 <= m) return k & 1 ? target + (k + 1) / 2 : target - k / 2;
+  return up > down ? target + (k - m) : target - (k - m);
+}
+
+/*
+ * Pick an edge of the integers in [first, last], as ordered bits: the
+ * bounds, 0, 1 and -1 when in range. While enumerating the value is chosen
+ * instead (see QCC_chooseOrdered). Returns 0 if a random value is to be
+ * drawn instead.
+ */
+static int QCC_edgeOrdered(uint64_t first, uint64_t last, uint64_t zero, QCC_Boolean isSigned, uint64_t *out) {
+  QCC_Rng *rng;
+  uint64_t candidates[5] = { zero, zero + 1, zero - 1, first, last };
+  uint64_t edges[5];
+  int n = 0, i, j;
+
+  if (QCC_currentEnum) {
+    *out = QCC_chooseOrdered(first, last, zero);
+    return 1;
+  }
+  rng = QCC_getRng();
+  if (!QCC_rngEdgeNext(rng)) return 0;
+  for (i=0; i<5; i++) {
+    if ((i == 2 && !isSigned) || candidates[i] < first || candidates[i] > last) continue;
+    for (j=0; j<n && edges[j] != candidates[i]; j++);
+    if (j == n) edges[n++] = candidates[i];
+  }
+  *out = edges[QCC_rngEdgePick(rng, n)];
+  return 1;
+}
+
+static int QCC_shrinkTowards(long v, long target, int idx, long *out) {
+  uint64_t c;
+
+  if (!QCC_shrinkOrdered((uint64_t) (int64_t) v ^ QCC_SIGN_BIT, (uint64_t) (int64_t) target ^ QCC_SIGN_BIT, idx, &c))
+    return 0;
+  *out = (long) (int64_t) (c ^ QCC_SIGN_BIT);
+  return 1;
+}
+
+static int QCC_shrinkTowardsDouble(double v, double target, int idx, double *out) {
+  double t = (v > -9e18 && v < 9e18) ? (double) (long long) v : v;
+
+  if (v == target || v != v) return 0;
+  if (idx == 0) {
+    *out = target;
+    return 1;
+  }
+  if (isinf(v)) return 0;
+  if (t != v && t != target && (t - target) * (v - t) > 0) {
+    if (idx == 1) {
+      *out = t;
+      return 1;
+    }
+    idx--;
+  }
+  if (idx > 24) return 0;
+  *out = v - (v - target) / (double) (1L << idx);
+  return *out != v;
+}
+
+static QCC_GenValue* QCC_shrinkSimpleValue(QCC_GenValue *gv, int idx, size_t elemSize, QCC_shrinkRaw shrinkElem, int bounded) {
+  size_t size = bounded ? 3*elemSize : elemSize;
+  uint8_t *v = QCC_alloc(size);
+
+  memcpy(v, gv->value, size);
+  if (!shrinkElem(gv->value, bounded ? (uint8_t *)gv->value + elemSize : NULL, idx, v)) {
+    QCC_freeAlloc(v);
+    return NULL;
+  }
+  return QCC_initShrinkableValue(v, 1, gv->show, gv->write, gv->free, gv->shrink, gv->mutate, gv->hash);
+}
+
+/*
+ * Mutation helpers.
+ * Built-in numbers mutate to a value of their range nearby, up or down:
+ * integers by a power of two up to 2^16, floating point values by a
+ * power of two fraction of their magnitude (or of 1 if smaller), from a
+ * half to 2^-24.
+ */
+#define QCC_NUDGE_STEPS 17
+
+static int QCC_nudgeOrdered(uint64_t v, uint64_t first, uint64_t last, QCC_Rng *rng, uint64_t *out) {
+  uint64_t d = 1ULL << QCC_rngBelow(rng, QCC_NUDGE_STEPS);
+  QCC_Boolean up = (QCC_rngNext(rng) >> 63) ? QCC_TRUE : QCC_FALSE;
+
+  if (up ? v >= last : v <= first) up = !up;
+  if (up) *out = last - v < d ? last : v + d;
+  else *out = v - first < d ? first : v - d;
+  return *out != v;
+}
+
+static int QCC_nudgeDouble(double v, double from, double to, QCC_Rng *rng, double *out) {
+  double d = (v < -1 ? -v : (v > 1 ? v : 1)) / (double) (2L << QCC_rngBelow(rng, 24));
+  QCC_Boolean up = (QCC_rngNext(rng) >> 63) ? QCC_TRUE : QCC_FALSE;
+
+  if (v != v || isinf(v)) return 0;
+  *out = up ? v + d : v - d;
+  if (!(from <= *out && *out < to)) *out = up ? v - d : v + d;
+  return from <= *out && *out < to && *out != v;
+}
+
+static QCC_GenValue* QCC_mutateSimpleValue(QCC_GenValue *gv, QCC_Rng *rng, size_t elemSize, QCC_nudgeRaw nudgeElem) {
+  uint8_t *v = QCC_alloc(3*elemSize);
+
+  memcpy(v, gv->value, 3*elemSize);
+  if (!nudgeElem(gv->value, (uint8_t *)gv->value + elemSize, rng, v)) {
+    QCC_freeAlloc(v);
+    return NULL;
+  }
+  return QCC_initShrinkableValue(v, 1, gv->show, gv->write, gv->free, gv->shrink, gv->mutate, gv->hash);
+}
+
+/***********************************************************************
+ *  Generators implementations
+ ***********************************************************************/
+
+static void QCC_writeLong(QCC_Sink *sink, void *value, int len) {
+  QCC_writeDecimal(sink, *(long*)value);
+}
+
+static char* QCC_showLong(void *value, int len) {
+  return QCC_showWritten(QCC_writeLong, value, len);
+}
+
+void QCC_rngLongAtR(QCC_Rng *rng, long *l, long *from, long *to) {
+  unsigned long n = (unsigned long) *to - (unsigned long) *from;
+  *l = (long) ((unsigned long) *from + (unsigned long) QCC_rngBelow(rng, n));
+}
+
+/* Unranged values span the whole type, both extremes included */
+void QCC_rngLongAt(QCC_Rng *rng, long *l) {
+  *l = (long) (unsigned long) QCC_rngNext(rng);
+}
+
+void QCC_genLongAtR(long *l, long *from, long *to) {
+  QCC_rngLongAtR(QCC_getRng(), l, from, to);
+}
+
+void QCC_genLongAt(long *l) {
+  QCC_rngLongAt(QCC_getRng(), l);
+}
+
+static int QCC_shrinkLongAt(void *l, void *bounds, int idx, void *out) {
+  long *b = bounds;
+  return QCC_shrinkTowards(*(long *)l, QCC_shrinkTarget(b[0], b[1]), idx, out);
+}
+
+static QCC_GenValue* QCC_shrinkLong(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(long), QCC_shrinkLongAt, 1);
+}
+
+static int QCC_nudgeLongAt(void *l, void *bounds, QCC_Rng *rng, void *out) {
+  long *b = bounds;
+  uint64_t c;
+
+  if (!QCC_nudgeOrdered(QCC_SIGNED_BITS(*(long *)l), QCC_SIGNED_BITS(b[0]), QCC_SIGNED_BITS(b[1]), rng, &c)) return 0;
+  *(long *)out = (long) (int64_t) (c ^ QCC_SIGN_BIT);
+  return 1;
+}
+
+static QCC_GenValue* QCC_mutateLong(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleValue(gv, rng, sizeof(long), QCC_nudgeLongAt);
+}
+
+/* Pick an edge of the longs in [first, last] (see QCC_edgeOrdered) */
+static int QCC_edgeLongAt(long *l, long first, long last) {
+  uint64_t e;
+
+  if (!QCC_edgeOrdered(QCC_SIGNED_BITS(first), QCC_SIGNED_BITS(last), QCC_SIGNED_BITS(0), QCC_TRUE, &e)) return 0;
+  *l = (long) (int64_t) (e ^ QCC_SIGN_BIT);
+  return 1;
+}
+
+QCC_GenValue* QCC_genLongRI(long first, long last) {
+  long *v = QCC_alloc(sizeof(long) * 3), to;
+  if (last < first) last = first;
+  /* to wraps around to first when the range spans the whole type */
+  to = (long) ((unsigned long) last + 1);
+  if (!QCC_edgeLongAt(v, first, last)) {
+    if (to == first) QCC_genLongAt(v);
+    else QCC_genLongAtR(v, &first, &to);
+  }
+  v[1] = first;
+  v[2] = last;
+
+  return QCC_initShrinkableValue(v, 1, QCC_showLong, QCC_writeLong, QCC_freeAlloc, QCC_shrinkLong, QCC_mutateLong, QCC_elemsHash(sizeof(long)));
+}
+
+QCC_GenValue* QCC_genLongR(long from, long to) {
+  return QCC_genLongRI(from, to > from ? to - 1 : from);
+}
+
+QCC_GenValue* QCC_genLong() {
+  return QCC_genLongRI(QCC_LONG_FROM, QCC_LONG_TO);
+}
+
+static void QCC_writeInt(QCC_Sink *sink, void *value, int len) {
+  QCC_writeDecimal(sink, *(int*)value);
+}
+
+static char* QCC_showInt(void *value, int len) {
+  return QCC_showWritten(QCC_writeInt, value, len);
+}
+
+void QCC_rngIntAtR(QCC_Rng *rng, int *i, int *from, int *to) {
+  unsigned int n = (unsigned int) *to - (unsigned int) *from;
+  *i = (int) ((unsigned int) *from + QCC_rngBelow32(rng, n));
+}
+
+void QCC_rngIntAt(QCC_Rng *rng, int *i) {
+  *i = (int) (unsigned int) (QCC_rngNext(rng) >> 32);
+}
+
+void QCC_genIntAtR(int *i, int *from, int *to) {
+  QCC_rngIntAtR(QCC_getRng(), i, from, to);
+}
+
+void QCC_genIntAt(int *i) {
+  QCC_rngIntAt(QCC_getRng(), i);
+}
+
+static int QCC_shrinkIntAt(void *i, void *bounds, int idx, void *out) {
+  int *b = bounds;
+  long c;
+
+  if (!QCC_shrinkTowards(*(int *)i, QCC_shrinkTarget(b[0], b[1]), idx, &c)) return 0;
+  *(int *)out = (int) c;
+  return 1;
+}
+
+static QCC_GenValue* QCC_shrinkInt(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(int), QCC_shrinkIntAt, 1);
+}
+
+static int QCC_nudgeIntAt(void *i, void *bounds, QCC_Rng *rng, void *out) {
+  int *b = bounds;
+  uint64_t c;
+
+  if (!QCC_nudgeOrdered(QCC_SIGNED_BITS(*(int *)i), QCC_SIGNED_BITS(b[0]), QCC_SIGNED_BITS(b[1]), rng, &c)) return 0;
+  *(int *)out = (int) (int64_t) (c ^ QCC_SIGN_BIT);
+  return 1;
+}
+
+static QCC_GenValue* QCC_mutateInt(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleValue(gv, rng, sizeof(int), QCC_nudgeIntAt);
+}
+
+QCC_GenValue* QCC_genIntRI(int first, int last) {
+  int *v = QCC_alloc(sizeof(int) * 3), to;
+  long e;
+  if (last < first) last = first;
+  to = (int) ((unsigned int) last + 1);
+  if (QCC_edgeLongAt(&e, first, last)) *v = (int) e;
+  else if (to == first) QCC_genIntAt(v);
+  else QCC_genIntAtR(v, &first, &to);
+  v[1] = first;
+  v[2] = last;
+
+  return QCC_initShrinkableValue(v, 1, QCC_showInt, QCC_writeInt, QCC_freeAlloc, QCC_shrinkInt, QCC_mutateInt, QCC_elemsHash(sizeof(int)));
+}
+
+QCC_GenValue* QCC_genIntR(int from, int to) {
+  return QCC_genIntRI(from, to > from ? to - 1 : from);
+}
+
+QCC_GenValue* QCC_genInt() {
+  return QCC_genIntRI(QCC_INT_FROM, QCC_INT_TO);
+}
+
+static void QCC_writeDouble(QCC_Sink *sink, void *value, int len) {
+  QCC_writeSimpleValue(sink, value, DOUBLE, "%.12e");
+}
+
+static char* QCC_showDouble(void *value, int len) {
+  return QCC_showWritten(QCC_writeDouble, value, len);
+}
+
+void QCC_rngDoubleAtR(QCC_Rng *rng, double *d, double *from, double *to) {
+  double r = (double) (QCC_rngNext(rng) >> 11) * 0x1.0p-53;
+  *d = *from + (*to - *from) * r;
+}
+
+void QCC_rngDoubleAt(QCC_Rng *rng, double *d) {
+  double from = QCC_DOUBLE_FROM;
+  double to = QCC_DOUBLE_TO;
+  QCC_rngDoubleAtR(rng, d, &from, &to);
+}
+
+void QCC_genDoubleAtR(double *d, double *from, double *to) {
+  QCC_rngDoubleAtR(QCC_getRng(), d, from, to);
+}
+
+void QCC_genDoubleAt(double *d) {
+  QCC_rngDoubleAt(QCC_getRng(), d);
+}
+
+/* Largest double below a finite x */
+static double QCC_nextDown(double x) {
+  uint64_t b;
+
+  if (x == 0) return -DBL_TRUE_MIN;
+  memcpy(&b, &x, sizeof(b));
+  b = x > 0 ? b - 1 : b + 1;
+  memcpy(&x, &b, sizeof(b));
+  return x;
+}
+
+static int QCC_shrinkDoubleAt(void *d, void *bounds, int idx, void *out) {
+  double *b = bounds;
+  double target = (b[0] <= 0 && 0 < b[1]) ? 0 : (b[0] > 0 ? b[0] : QCC_nextDown(b[1]));
+  return QCC_shrinkTowardsDouble(*(double *)d, target, idx, out);
+}
+
+static QCC_GenValue* QCC_shrinkDouble(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(double), QCC_shrinkDoubleAt, 1);
+}
+
+static int QCC_nudgeDoubleAt(void *d, void *bounds, QCC_Rng *rng, void *out) {
+  double *b = bounds;
+  return QCC_nudgeDouble(*(double *)d, b[0], b[1], rng, out);
+}
+
+static QCC_GenValue* QCC_mutateDouble(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleValue(gv, rng, sizeof(double), QCC_nudgeDoubleAt);
+}
+
+/*
+ * Pick an edge of the floating point values in [from, to), below being
+ * the largest value under to: the bounds, then 0.0, -0.0, 1.0, -1.0, the
+ * smallest normal values and the smallest denormals of the type when in
+ * range, telling 0.0 and -0.0 apart. Returns 0 if a random value is to be
+ * drawn instead.
+ */
+static int QCC_edgeFloatingRange(double from, double to, double below, double min, double trueMin, double *out) {
+  QCC_Rng *rng = QCC_getRng();
+  double candidates[10] = { from, below, 0.0, -0.0, 1.0, -1.0, min, -min, trueMin, -trueMin };
+  double edges[10];
+  int n = 0, i, j;
+
+  if (!QCC_rngEdgeNext(rng)) return 0;
+  for (i=0; i<10; i++) {
+    if (i == 1 && to <= from) continue;
+    if (i > 1 && !(from <= candidates[i] && candidates[i] < to)) continue;
+    for (j=0; j<n && memcmp(&edges[j], &candidates[i], sizeof(double)); j++);
+    if (j == n) edges[n++] = candidates[i];
+  }
+  *out = edges[QCC_rngEdgePick(rng, n)];
+  return 1;
+}
+
+/* Edges of QCC_genDoubleSpecial, out of the range of the other generators */
+static const double QCC_doubleSpecials[] = {
+  DBL_MAX, -DBL_MAX, INFINITY, -INFINITY, NAN
+};
+
+QCC_GenValue* QCC_genDoubleR(double from, double to) {
+  double *v = QCC_alloc(sizeof(double) * 3);
+  if (!QCC_edgeFloatingRange(from, to, to > from ? QCC_nextDown(to) : from, DBL_MIN, DBL_TRUE_MIN, v)) QCC_genDoubleAtR(v, &from, &to);
+  v[1] = from;
+  v[2] = to;
+  return QCC_initShrinkableValue(v, 1, QCC_showDouble, QCC_writeDouble, QCC_freeAlloc, QCC_shrinkDouble, QCC_mutateDouble, QCC_elemsHash(sizeof(double)));
+}
+
+QCC_GenValue* QCC_genDouble() {
+  return QCC_genDoubleR(QCC_DOUBLE_FROM, QCC_DOUBLE_TO);
+}
+
+QCC_GenValue* QCC_genDoubleSpecial() {
+  double *v;
+  int edge = QCC_edgeIndex(sizeof(QCC_doubleSpecials) / sizeof(double));
+
+  if (edge < 0) return QCC_genDouble();
+  v = QCC_alloc(sizeof(double) * 3);
+  *v = QCC_doubleSpecials[edge];
+  v[1] = QCC_DOUBLE_FROM;
+  v[2] = QCC_DOUBLE_TO;
+  return QCC_initShrinkableValue(v, 1, QCC_showDouble, QCC_writeDouble, QCC_freeAlloc, QCC_shrinkDouble, QCC_mutateDouble, QCC_elemsHash(sizeof(double)));
+}
+
+static void QCC_writeFloat(QCC_Sink *sink, void *value, int len) {
+  QCC_writeSimpleValue(sink, value, FLOAT, "%.12e");
+}
+
+static char* QCC_showFloat(void *value, int len) {
+  return QCC_showWritten(QCC_writeFloat, value, len);
+}
+
+void QCC_rngFloatAtR(QCC_Rng *rng, float *f, float *from, float *to) {
+  float r = (float) (QCC_rngNext(rng) >> 40) * 0x1.0p-24f;
+  *f = *from + (*to - *from) * r;
+}
+
+void QCC_rngFloatAt(QCC_Rng *rng, float *f) {
+  float from = QCC_FLOAT_FROM;
+  float to = QCC_FLOAT_TO;
+  QCC_rngFloatAtR(rng, f, &from, &to);
+}
+
+void QCC_genFloatAtR(float *f, float *from, float *to) {
+  QCC_rngFloatAtR(QCC_getRng(), f, from, to);
+}
+
+void QCC_genFloatAt(float *f) {
+  QCC_rngFloatAt(QCC_getRng(), f);
+}
+
+/* Largest float below a finite x */
+static float QCC_nextDownFloat(float x) {
+  uint32_t b;
+
+  if (x == 0) return -FLT_TRUE_MIN;
+  memcpy(&b, &x, sizeof(b));
+  b = x > 0 ? b - 1 : b + 1;
+  memcpy(&x, &b, sizeof(b));
+  return x;
+}
+
+static int QCC_shrinkFloatAt(void *f, void *bounds, int idx, void *out) {
+  float *b = bounds;
+  float target = (b[0] <= 0 && 0 < b[1]) ? 0 : (b[0] > 0 ? b[0] : QCC_nextDownFloat(b[1]));
+  double c;
+
+  while (QCC_shrinkTowardsDouble(*(float *)f, target, idx, &c)) {
+    /* Skip candidates collapsing back on the value once narrowed to float */
+    if ((float) c != *(float *)f) {
+      *(float *)out = (float) c;
+      return 1;
+    }
+    idx++;
+  }
+  return 0;
+}
+
+static QCC_GenValue* QCC_shrinkFloat(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(float), QCC_shrinkFloatAt, 1);
+}
+
+static int QCC_nudgeFloatAt(void *f, void *bounds, QCC_Rng *rng, void *out) {
+  float *b = bounds;
+  double c;
+
+  if (!QCC_nudgeDouble(*(float *)f, b[0], b[1], rng, &c) || (float) c == *(float *)f || !((float) c < b[1])) return 0;
+  *(float *)out = (float) c;
+  return 1;
+}
+
+static QCC_GenValue* QCC_mutateFloat(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleValue(gv, rng, sizeof(float), QCC_nudgeFloatAt);
+}
+
+static const float QCC_floatSpecials[] = {
+  FLT_MAX, -FLT_MAX, INFINITY, -INFINITY, NAN
+};
+
+QCC_GenValue* QCC_genFloatR(float from, float to) {
+  float *v = QCC_alloc(sizeof(float) * 3);
+  double e;
+  if (QCC_edgeFloatingRange(from, to, to > from ? QCC_nextDownFloat(to) : from, FLT_MIN, FLT_TRUE_MIN, &e)) *v = (float) e;
+  else QCC_genFloatAtR(v, &from, &to);
+  v[1] = from;
+  v[2] = to;
+
+  return QCC_initShrinkableValue(v, 1, QCC_showFloat, QCC_writeFloat, QCC_freeAlloc, QCC_shrinkFloat, QCC_mutateFloat, QCC_elemsHash(sizeof(float)));
+}
+
+QCC_GenValue* QCC_genFloat() {
+  return QCC_genFloatR(QCC_FLOAT_FROM, QCC_FLOAT_TO);
+}
+
+QCC_GenValue* QCC_genFloatSpecial() {
+  float *v;
+  int edge = QCC_edgeIndex(sizeof(QCC_floatSpecials) / sizeof(float));
+
+  if (edge < 0) return QCC_genFloat();
+  v = QCC_alloc(sizeof(float) * 3);
+  *v = QCC_floatSpecials[edge];
+  v[1] = QCC_FLOAT_FROM;
+  v[2] = QCC_FLOAT_TO;
+
+  return QCC_initShrinkableValue(v, 1, QCC_showFloat, QCC_writeFloat, QCC_freeAlloc, QCC_shrinkFloat, QCC_mutateFloat, QCC_elemsHash(sizeof(float)));
+}
+
+static void QCC_writeBoolean(QCC_Sink *sink, void *value, int len) {
+  QCC_Boolean *b = (QCC_Boolean *)value;
+
+  if (*b) QCC_sinkWrite(sink, "TRUE", 4);
+  else QCC_sinkWrite(sink, "FALSE", 5);
+}
+
+static char* QCC_showBoolean(void *value, int len) {
+  return QCC_showWritten(QCC_writeBoolean, value, len);
+}
+
+void QCC_rngBooleanAt(QCC_Rng *rng, QCC_Boolean *b) {
+  *b = (QCC_rngNext(rng) >> 63) ? QCC_TRUE : QCC_FALSE;
+}
+
+void QCC_genBooleanAt(QCC_Boolean *b) {
+  QCC_rngBooleanAt(QCC_getRng(), b);
+}
+
+static int QCC_shrinkBooleanAt(void *b, void *bounds, int idx, void *out) {
+  if (idx > 0 || *(QCC_Boolean *)b == QCC_FALSE) return 0;
+  *(QCC_Boolean *)out = QCC_FALSE;
+  return 1;
+}
+
+static QCC_GenValue* QCC_shrinkBoolean(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(QCC_Boolean), QCC_shrinkBooleanAt, 0);
+}
+
+QCC_GenValue* QCC_genBoolean() {
+  QCC_Boolean *v = QCC_alloc(sizeof(QCC_Boolean));
+  if (QCC_currentEnum) *v = QCC_choose(2) ? QCC_TRUE : QCC_FALSE;
+  else QCC_genBooleanAt(v);
+
+  return QCC_initShrinkableValue(v, 1, QCC_showBoolean, QCC_writeBoolean, QCC_freeAlloc, QCC_shrinkBoolean, NULL, QCC_elemsHash(sizeof(QCC_Boolean)));
+}
+
+static void QCC_writeChar(QCC_Sink *sink, void *value, int len) {
+  QCC_writeSimpleValue(sink, value, CHAR, "'%c'");
+}
+
+static char* QCC_showChar(void *value, int len) {
+  return QCC_showWritten(QCC_writeChar, value, len);
+}
+
+void QCC_rngCharAt(QCC_Rng *rng, char *c) {
+  *c = (char) (QCC_rngNext(rng) % 93) + 33;
+}
+
+void QCC_genCharAt(char *c) {
+  QCC_rngCharAt(QCC_getRng(), c);
+}
+
+/* Characters shrink towards 'a' */
+static int QCC_shrinkCharAt(void *c, void *bounds, int idx, void *out) {
+  long s;
+
+  if (!QCC_shrinkTowards(*(char *)c, 'a', idx, &s)) return 0;
+  *(char *)out = (char) s;
+  return 1;
+}
+
+static QCC_GenValue* QCC_shrinkChar(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(char), QCC_shrinkCharAt, 0);
+}
+
+/* The first and last characters generated, and the usual escaping troublemakers */
+static const char QCC_charEdges[] = { '!', '}', '"', '\\' };
+
+QCC_GenValue* QCC_genChar() {
+  char *v = QCC_alloc(sizeof(char));
+  int edge = QCC_edgeIndex(sizeof(QCC_charEdges));
+  if (QCC_currentEnum) *v = (char) QCC_chooseOrdered(33, 125, 'a');
+  else if (edge >= 0) *v = QCC_charEdges[edge];
+  else QCC_genCharAt(v);
+
+  return QCC_initShrinkableValue(v, 1, QCC_showChar, QCC_writeChar, QCC_freeAlloc, QCC_shrinkChar, NULL, QCC_elemsHash(sizeof(char)));
+}
+
+/*
+ * Fixed width integers. Values map to bits ordered as unsigned integers
+ * (see QCC_shrinkOrdered), where ranges and shrink targets are computed
+ * for all the types alike. Values are stored followed by their range.
+ */
+#define QCC_FIXED_WIDTH(Name, type, min, max, isSigned)                                          \
+static uint64_t QCC_bits##Name(type v) {                                                         \
+  return isSigned ? QCC_SIGNED_BITS(v) : QCC_UNSIGNED_BITS(v);                                   \
+}                                                                                                \
+                                                                                                 \
+static type QCC_from##Name##Bits(uint64_t b) {                                                   \
+  return isSigned ? (type) (int64_t) (b ^ QCC_SIGN_BIT) : (type) b;                              \
+}                                                                                                \
+                                                                                                 \
+static void QCC_write##Name(QCC_Sink *sink, void *value, int len) {                              \
+  type v = *(type *) value;                                                                      \
+  if (isSigned && (int64_t) v < 0) QCC_writeDigits(sink, -(uint64_t) (int64_t) v, QCC_TRUE);     \
+  else QCC_writeDigits(sink, (uint64_t) v, QCC_FALSE);                                           \
+}                                                                                                \
+                                                                                                 \
+static char* QCC_show##Name(void *value, int len) {                                              \
+  return QCC_showWritten(QCC_write##Name, value, len);                                           \
+}                                                                                                \
+                                                                                                 \
+void QCC_rng##Name##AtR(QCC_Rng *rng, type *v, type *from, type *to) {                           \
+  uint64_t f = QCC_bits##Name(*from);                                                            \
+  *v = QCC_from##Name##Bits(f + QCC_rngBelow(rng, QCC_bits##Name(*to) - f));                     \
+}                                                                                                \
+                                                                                                 \
+void QCC_rng##Name##At(QCC_Rng *rng, type *v) {                                                  \
+  *v = QCC_from##Name##Bits(QCC_bits##Name(min) + (QCC_rngNext(rng) >> (64 - 8 * sizeof(type)))); \
+}                                                                                                \
+                                                                                                 \
+static int QCC_shrink##Name##At(void *v, void *bounds, int idx, void *out) {                     \
+  type *b = bounds;                                                                              \
+  uint64_t f = QCC_bits##Name(b[0]), t = QCC_bits##Name(b[1]), zero = QCC_bits##Name(0), c;      \
+  uint64_t target = f > zero ? f : (t < zero ? t : zero);                                        \
+                                                                                                 \
+  if (!QCC_shrinkOrdered(QCC_bits##Name(*(type *) v), target, idx, &c)) return 0;                \
+  *(type *) out = QCC_from##Name##Bits(c);                                                       \
+  return 1;                                                                                      \
+}                                                                                                \
+                                                                                                 \
+static QCC_GenValue* QCC_shrink##Name(QCC_GenValue *gv, int idx) {                               \
+  return QCC_shrinkSimpleValue(gv, idx, sizeof(type), QCC_shrink##Name##At, 1);                  \
+}                                                                                                \
+                                                                                                 \
+static int QCC_nudge##Name##At(void *v, void *bounds, QCC_Rng *rng, void *out) {                 \
+  type *b = bounds;                                                                              \
+  uint64_t f = QCC_bits##Name(b[0]), t = QCC_bits##Name(b[1]), c;                                \
+                                                                                                 \
+  if (!QCC_nudgeOrdered(QCC_bits##Name(*(type *) v), f, t, rng, &c)) return 0;                   \
+  *(type *) out = QCC_from##Name##Bits(c);                                                       \
+  return 1;                                                                                      \
+}                                                                                                \
+                                                                                                 \
+static QCC_GenValue* QCC_mutate##Name(QCC_GenValue *gv, QCC_Rng *rng) {                          \
+  return QCC_mutateSimpleValue(gv, rng, sizeof(type), QCC_nudge##Name##At);                      \
+}                                                                                                \
+                                                                                                 \
+QCC_GenValue* QCC_gen##Name##RI(type first, type last) {                                         \
+  type *v = QCC_alloc(sizeof(type) * 3);                                                         \
+  uint64_t f = QCC_bits##Name(first), t = QCC_bits##Name(last), e;                               \
+  if (t < f) t = f;                                                                              \
+  if (QCC_edgeOrdered(f, t, QCC_bits##Name(0), isSigned, &e)) *v = QCC_from##Name##Bits(e);      \
+  else if (t - f + 1 == 0) QCC_rng##Name##At(QCC_getRng(), v);                                   \
+  else *v = QCC_from##Name##Bits(f + QCC_rngBelow(QCC_getRng(), t - f + 1));                     \
+  v[1] = first;                                                                                  \
+  v[2] = QCC_from##Name##Bits(t);                                                                \
+                                                                                                 \
+  return QCC_initShrinkableValue(v, 1, QCC_show##Name, QCC_write##Name, QCC_freeAlloc, QCC_shrink##Name, QCC_mutate##Name, QCC_elemsHash(sizeof(type))); \
+}                                                                                                \
+                                                                                                 \
+QCC_GenValue* QCC_gen##Name##R(type from, type to) {                                             \
+  return QCC_gen##Name##RI(from, to > from ? (type) (to - 1) : from);                            \
+}                                                                                                \
+                                                                                                 \
+QCC_GenValue* QCC_gen##Name() {                                                                  \
+  return QCC_gen##Name##RI(min, max);                                                            \
+}
+
+QCC_FIXED_WIDTH(Int8, int8_t, INT8_MIN, INT8_MAX, 1)
+QCC_FIXED_WIDTH(Uint8, uint8_t, 0, UINT8_MAX, 0)
+QCC_FIXED_WIDTH(Int16, int16_t, INT16_MIN, INT16_MAX, 1)
+QCC_FIXED_WIDTH(Uint16, uint16_t, 0, UINT16_MAX, 0)
+QCC_FIXED_WIDTH(Int32, int32_t, INT32_MIN, INT32_MAX, 1)
+QCC_FIXED_WIDTH(Uint32, uint32_t, 0, UINT32_MAX, 0)
+QCC_FIXED_WIDTH(Int64, int64_t, INT64_MIN, INT64_MAX, 1)
+QCC_FIXED_WIDTH(Uint64, uint64_t, 0, UINT64_MAX, 0)
+QCC_FIXED_WIDTH(SizeT, size_t, 0, SIZE_MAX, 0)
+
+
+/***********************************************************************
+ *  Array generators implementations
+ ***********************************************************************/
+
+QCC_GenValue* QCC_genArrayFill(int len, QCC_fillRaw fill, size_t elemSize, QCC_showValue show, QCC_writeValue write, QCC_freeValue free, QCC_shrinkValue shrink, QCC_mutateValue mutate) {
+  QCC_Rng *rng = QCC_getRng();
+  int n = QCC_rngLength(rng, len);
+  uint8_t *arr = QCC_alloc(n*elemSize);
+
+  fill(rng, arr, n);
+
+  return QCC_initShrinkableValue(arr, n, show, write, free, shrink, mutate, QCC_elemsHash(elemSize));
+}
+
+/*
+ * Ranged arrays store the range right after the last element (see
+ * QCC_shrinkSimpleArray).
+ */
+QCC_GenValue* QCC_genArrayFillR(int len, QCC_fillRawR fill, const void *from, const void *to, size_t elemSize, QCC_showValue show, QCC_writeValue write, QCC_freeValue free, QCC_shrinkValue shrink, QCC_mutateValue mutate) {
+  QCC_Rng *rng = QCC_getRng();
+  int n = QCC_rngLength(rng, len);
+  uint8_t *arr = QCC_alloc((n+2)*elemSize);
+
+  fill(rng, arr, n, from, to);
+  memcpy(arr + n*elemSize, from, elemSize);
+  memcpy(arr + (n+1)*elemSize, to, elemSize);
+
+  return QCC_initShrinkableValue(arr, n, show, write, free, shrink, mutate, QCC_elemsHash(elemSize));
+}
+
+/*
+ * Array shrink candidates first remove chunks of decreasing size (the
+ * whole array, halves, quarters, ... single elements), then shrink single
+ * elements in place. The trailer following the elements (range bounds or
+ * string terminator) is preserved.
+ */
+static QCC_GenValue* QCC_shrinkSimpleArray(QCC_GenValue *gv, int idx, size_t elemSize, QCC_shrinkRaw shrinkElem, int bounded, int terminated) {
+  uint8_t *arr = gv->value;
+  int m = terminated ? gv->n - 1 : gv->n;
+  size_t trailer = bounded ? 2*elemSize : (terminated ? elemSize : 0);
+  uint8_t *bounds = bounded ? arr + m*elemSize : NULL;
+  uint8_t *narr;
+  uint8_t elem[sizeof(long double)];
+  int k, i, j;
+
+  for (k=m; k>0; k/=2) {
+    int chunks = (m + k - 1) / k;
+    if (idx < chunks) {
+      int start = idx*k;
+      int end = start + k < m ? start + k : m;
+      int nm = m - (end - start);
+
+      narr = QCC_alloc(nm*elemSize + trailer);
+      memcpy(narr, arr, start*elemSize);
+      memcpy(narr + start*elemSize, arr + end*elemSize, (m-end)*elemSize + trailer);
+      return QCC_initShrinkableValue(narr, terminated ? nm+1 : nm, gv->show, gv->write, gv->free, gv->shrink, gv->mutate, gv->hash);
+    }
+    idx -= chunks;
+  }
+
+  for (i=0; i<m; i++) {
+    for (j=0; shrinkElem(arr + i*elemSize, bounds, j, elem); j++) {
+      if (idx-- == 0) {
+        narr = QCC_alloc(m*elemSize + trailer);
+        memcpy(narr, arr, m*elemSize + trailer);
+        memcpy(narr + i*elemSize, elem, elemSize);
+        return QCC_initShrinkableValue(narr, gv->n, gv->show, gv->write, gv->free, gv->shrink, gv->mutate, gv->hash);
+      }
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Array mutations keep the length and the trailer of the array, and pick
+ * one of: swapping two elements, sorting a run either way, reversing a
+ * run or copying an element over another one. Sorted and reversed runs
+ * move arrays towards the orders many algorithms are slowest on.
+ */
+static void QCC_swapElems(uint8_t *arr, size_t elemSize, int a, int b) {
+  uint8_t tmp[sizeof(long double)];
+
+  memcpy(tmp, arr + a*elemSize, elemSize);
+  memcpy(arr + a*elemSize, arr + b*elemSize, elemSize);
+  memcpy(arr + b*elemSize, tmp, elemSize);
+}
+
+static void QCC_reverseElems(uint8_t *arr, size_t elemSize, int a, int b) {
+  for (; a < b; a++, b--) QCC_swapElems(arr, elemSize, a, b);
+}
+
+static QCC_GenValue* QCC_mutateSimpleArray(QCC_GenValue *gv, QCC_Rng *rng, size_t elemSize,
+                                           int (*compare)(const void *, const void *), int bounded, int terminated) {
+  int m = terminated ? gv->n - 1 : gv->n;
+  size_t trailer = bounded ? 2*elemSize : (terminated ? elemSize : 0);
+  uint8_t *narr;
+  int a, b, t;
+
+  if (m < 2) return NULL;
+  a = (int) QCC_rngBelow(rng, m);
+  b = (int) QCC_rngBelow(rng, m - 1);
+  if (b >= a) b++;
+  if (a > b) {
+    t = a;
+    a = b;
+    b = t;
+  }
+
+  narr = QCC_alloc(m*elemSize + trailer);
+  memcpy(narr, gv->value, m*elemSize + trailer);
+  switch (QCC_rngBelow(rng, 4)) {
+  case 0:
+    QCC_swapElems(narr, elemSize, a, b);
+    break;
+  case 1:
+    qsort(narr + a*elemSize, b - a + 1, elemSize, compare);
+    if (QCC_rngNext(rng) >> 63) QCC_reverseElems(narr, elemSize, a, b);
+    break;
+  case 2:
+    QCC_reverseElems(narr, elemSize, a, b);
+    break;
+  default:
+    if (QCC_rngNext(rng) >> 63) memcpy(narr + b*elemSize, narr + a*elemSize, elemSize);
+    else memcpy(narr + a*elemSize, narr + b*elemSize, elemSize);
+  }
+  return QCC_initShrinkableValue(narr, gv->n, gv->show, gv->write, gv->free, gv->shrink, gv->mutate, gv->hash);
+}
+
+static int QCC_compareLong(const void *a, const void *b) {
+  long x = *(const long *) a, y = *(const long *) b;
+  return (x > y) - (x < y);
+}
+
+static int QCC_compareInt(const void *a, const void *b) {
+  int x = *(const int *) a, y = *(const int *) b;
+  return (x > y) - (x < y);
+}
+
+static int QCC_compareDouble(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static int QCC_compareFloat(const void *a, const void *b) {
+  float x = *(const float *) a, y = *(const float *) b;
+  return (x > y) - (x < y);
+}
+
+static int QCC_compareBoolean(const void *a, const void *b) {
+  return (int) *(const QCC_Boolean *) a - (int) *(const QCC_Boolean *) b;
+}
+
+static int QCC_compareChar(const void *a, const void *b) {
+  return (int) *(const char *) a - (int) *(const char *) b;
+}
+
+static void QCC_writeString(QCC_Sink *sink, void *value, int len) {
+  int n = (int) strnlen(value, len);
+
+  if (sink->maxElems && n > sink->maxElems) {
+    QCC_sinkWrite(sink, value, sink->maxElems);
+    QCC_sinkPrintf(sink, "... %d more", n - sink->maxElems);
+  } else {
+    QCC_sinkWrite(sink, value, n);
+  }
+}
+
+static char *QCC_showString(void *value, int len) {
+  return QCC_showWritten(QCC_writeString, value, len);
+}
+
+static QCC_GenValue* QCC_shrinkString(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(char), QCC_shrinkCharAt, 0, 1);
+}
+
+static QCC_GenValue* QCC_mutateString(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(char), QCC_compareChar, 0, 1);
+}
+
+/* The string length n accounts for the terminator, so it is at least 1 */
+QCC_GenValue* QCC_genStringL(int len) {
+  QCC_Rng *rng = QCC_getRng();
+  int n = QCC_rngLength(rng, len);
+  if (n == 0) n = 1;
+  char *str = QCC_alloc(n);
+
+  QCC_rngFillChar(rng, str, n-1);
+  str[n-1] = '\0';
+
+  return QCC_initShrinkableValue(str, n, QCC_showString, QCC_writeString, QCC_freeAlloc, QCC_shrinkString, QCC_mutateString, QCC_elemsHash(sizeof(char)));
+}
+
+QCC_GenValue* QCC_genString() {
+  return QCC_genStringL(50);
+}
+
+/*
+ * Arrays longer than the sink maxElems are elided in the middle, keeping
+ * their first and last elements.
+ */
+static void QCC_writeSimpleArray(QCC_Sink *sink, void *value, size_t elemSize, QCC_writeValue writeValue, int len) {
+  int head = len, tail = 0;
+  int i;
+
+  if (sink->maxElems && len > sink->maxElems) {
+    head = (sink->maxElems + 1) / 2;
+    tail = sink->maxElems / 2;
+  }
+
+  QCC_sinkWrite(sink, "[", 1);
+  for (i=0; i<len; i++) {
+    if (i == head) {
+      QCC_sinkPrintf(sink, "%s... %d more", i ? ", " : "", len - head - tail);
+      i = len - tail;
+      if (i == len) break;
+    }
+    if (i) QCC_sinkWrite(sink, ", ", 2);
+    writeValue(sink, ((uint8_t *)value) + (i*elemSize), 1);
+  }
+  QCC_sinkWrite(sink, "]", 1);
+}
+
+static void QCC_writeArrayLong(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(long), QCC_writeLong, n);
+}
+
+static char* QCC_showArrayLong(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayLong, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayLong(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(long), QCC_shrinkLongAt, 1, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayLong(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(long), QCC_compareLong, 1, 0);
+}
+
+static QCC_GenValue* QCC_genArrayLongLRI(int len, long first, long last) {
+  return QCC_genArrayFillR(len, QCC_fillLongR, &first, &last, sizeof(long), QCC_showArrayLong, QCC_writeArrayLong, QCC_freeAlloc, QCC_shrinkArrayLong, QCC_mutateArrayLong);
+}
+
+QCC_GenValue* QCC_genArrayLongLR(int len, long from, long to) {
+  return QCC_genArrayLongLRI(len, from, to > from ? to - 1 : from);
+}
+
+QCC_GenValue* QCC_genArrayLongL(int len) {
+  return QCC_genArrayLongLRI(len, QCC_LONG_FROM, QCC_LONG_TO);
+}
+
+QCC_GenValue* QCC_genArrayLong() {
+  return QCC_genArrayLongLRI(50, QCC_LONG_FROM, QCC_LONG_TO);
+}
+
+static void QCC_writeArrayInt(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(int), QCC_writeInt, n);
+}
+
+static char* QCC_showArrayInt(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayInt, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayInt(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(int), QCC_shrinkIntAt, 1, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayInt(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(int), QCC_compareInt, 1, 0);
+}
+
+static QCC_GenValue* QCC_genArrayIntLRI(int len, int first, int last) {
+  return QCC_genArrayFillR(len, QCC_fillIntR, &first, &last, sizeof(int), QCC_showArrayInt, QCC_writeArrayInt, QCC_freeAlloc, QCC_shrinkArrayInt, QCC_mutateArrayInt);
+}
+
+QCC_GenValue* QCC_genArrayIntLR(int len, int from, int to) {
+  return QCC_genArrayIntLRI(len, from, to > from ? to - 1 : from);
+}
+
+QCC_GenValue* QCC_genArrayIntL(int len) {
+  return QCC_genArrayIntLRI(len, QCC_INT_FROM, QCC_INT_TO);
+}
+
+QCC_GenValue* QCC_genArrayInt() {
+  return QCC_genArrayIntLRI(50, QCC_INT_FROM, QCC_INT_TO);
+}
+
+static void QCC_writeArrayDouble(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(double), QCC_writeDouble, n);
+}
+
+static char* QCC_showArrayDouble(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayDouble, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayDouble(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(double), QCC_shrinkDoubleAt, 1, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayDouble(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(double), QCC_compareDouble, 1, 0);
+}
+
+QCC_GenValue* QCC_genArrayDoubleLR(int len, double from, double to) {
+  return QCC_genArrayFillR(len, QCC_fillDoubleR, &from, &to, sizeof(double), QCC_showArrayDouble, QCC_writeArrayDouble, QCC_freeAlloc, QCC_shrinkArrayDouble, QCC_mutateArrayDouble);
+}
+
+QCC_GenValue* QCC_genArrayDoubleL(int len) {
+  return QCC_genArrayDoubleLR(len, QCC_DOUBLE_FROM, QCC_DOUBLE_TO);
+}
+
+QCC_GenValue* QCC_genArrayDouble() {
+  return QCC_genArrayDoubleLR(50, QCC_DOUBLE_FROM, QCC_DOUBLE_TO);
+}
+
+static void QCC_writeArrayFloat(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(float), QCC_writeFloat, n);
+}
+
+static char* QCC_showArrayFloat(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayFloat, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayFloat(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(float), QCC_shrinkFloatAt, 1, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayFloat(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(float), QCC_compareFloat, 1, 0);
+}
+
+QCC_GenValue* QCC_genArrayFloatLR(int len, float from, float to) {
+  return QCC_genArrayFillR(len, QCC_fillFloatR, &from, &to, sizeof(float), QCC_showArrayFloat, QCC_writeArrayFloat, QCC_freeAlloc, QCC_shrinkArrayFloat, QCC_mutateArrayFloat);
+}
+
+QCC_GenValue* QCC_genArrayFloatL(int len) {
+  return QCC_genArrayFloatLR(len, QCC_FLOAT_FROM, QCC_FLOAT_TO);
+}
+
+QCC_GenValue* QCC_genArrayFloat() {
+  return QCC_genArrayFloatLR(50, QCC_FLOAT_FROM, QCC_FLOAT_TO);
+}
+
+static void QCC_writeArrayBoolean(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(QCC_Boolean), QCC_writeBoolean, n);
+}
+
+static char* QCC_showArrayBoolean(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayBoolean, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayBoolean(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(QCC_Boolean), QCC_shrinkBooleanAt, 0, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayBoolean(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(QCC_Boolean), QCC_compareBoolean, 0, 0);
+}
+
+QCC_GenValue* QCC_genArrayBooleanL(int len) {
+  return QCC_genArrayFill(len, QCC_fillBoolean, sizeof(QCC_Boolean), QCC_showArrayBoolean, QCC_writeArrayBoolean, QCC_freeAlloc, QCC_shrinkArrayBoolean, QCC_mutateArrayBoolean);
+}
+
+QCC_GenValue* QCC_genArrayBoolean() {
+  return QCC_genArrayBooleanL(50);
+}
+
+static void QCC_writeArrayChar(QCC_Sink *sink, void *value, int n) {
+  QCC_writeSimpleArray(sink, value, sizeof(char), QCC_writeChar, n);
+}
+
+static char* QCC_showArrayChar(void *value, int n) {
+  return QCC_showWritten(QCC_writeArrayChar, value, n);
+}
+
+static QCC_GenValue* QCC_shrinkArrayChar(QCC_GenValue *gv, int idx) {
+  return QCC_shrinkSimpleArray(gv, idx, sizeof(char), QCC_shrinkCharAt, 0, 0);
+}
+
+static QCC_GenValue* QCC_mutateArrayChar(QCC_GenValue *gv, QCC_Rng *rng) {
+  return QCC_mutateSimpleArray(gv, rng, sizeof(char), QCC_compareChar, 0, 0);
+}
+
+QCC_GenValue* QCC_genArrayCharL(int len) {
+  return QCC_genArrayFill(len, QCC_fillChar, sizeof(char), QCC_showArrayChar, QCC_writeArrayChar, QCC_freeAlloc, QCC_shrinkArrayChar, QCC_mutateArrayChar);
+}
+
+QCC_GenValue* QCC_genArrayChar() {
+  return QCC_genArrayCharL(50);
+}
+
+/***********************************************************************
+ *  Generator combinators
+ ***********************************************************************/
+#define QCC_FILTER_TRIES 100
+
+/*
+ * Values built by map, filter, bind and tuple keep what they need to shrink
+ * in a larger header, recognized by its QCC_shrinkDerived shrink function.
+ * Shrink candidates are those of the parts the value was built from (the
+ * wrapped value, bind source and result, tuple elements), in order, each
+ * rebuilt into a derived value or rejected. The header remembers where the
+ * last candidate was found so that enumerating candidates in order scans
+ * the parts once.
+ * Parts shared by a value and its candidates (bind sources, tuple elements)
+ * are reference counted.
+ */
+typedef enum { QCC_DERIVED_MAP, QCC_DERIVED_FILTER, QCC_DERIVED_BIND, QCC_DERIVED_TUPLE } QCC_DerivedKind;
+
+typedef struct QCC_SharedValue {
+  QCC_GenValue *value;
+  int refs;
+} QCC_SharedValue;
+
+typedef struct QCC_DerivedValue {
+  QCC_GenValue gv;
+  QCC_DerivedKind kind;
+  /* Wrapped value (map, filter) or bind result, whose payload gv mirrors */
+  QCC_GenValue *inner;
+  /* Bind source or tuple elements */
+  QCC_SharedValue **shared;
+  int sharedN;
+  QCC_mapValue map;
+  QCC_predicate pred;
+  QCC_bindValue bind;
+  uint64_t seed;
+  int size;
+  int lastIdx;
+  int part;
+  int partIdx;
+} QCC_DerivedValue;
+
+static _Thread_local uint64_t QCC_filterTries = 0;
+static _Thread_local uint64_t QCC_filterRejects = 0;
+
+static QCC_GenValue* QCC_shrinkDerived(QCC_GenValue *gv, int idx);
+
+static QCC_SharedValue* QCC_share(QCC_GenValue *value) {
+  QCC_SharedValue *s = QCC_alloc(sizeof(QCC_SharedValue));
+  *s = (QCC_SharedValue) { .value=value, .refs=1 };
+  return s;
+}
+
+static void QCC_release(QCC_SharedValue *s) {
+  if (--s->refs) return;
+  QCC_freeGenValue(s->value);
+  QCC_freeAlloc(s);
+}
+
+static QCC_DerivedValue* QCC_newDerived(QCC_DerivedValue *proto, QCC_GenValue *inner, int sharedN) {
+  QCC_DerivedValue *d = QCC_alloc(sizeof(QCC_DerivedValue));
+  *d = *proto;
+  d->inner = inner;
+  d->sharedN = sharedN;
+  d->shared = sharedN ? QCC_alloc(sizeof(QCC_SharedValue *) * sharedN) : NULL;
+  d->lastIdx = -1;
+  d->part = d->partIdx = 0;
+  if (inner)
+    d->gv = (QCC_GenValue) { .value=inner->value, .n=inner->n, .show=inner->show, .free=inner->free,
+                             .shrink=QCC_shrinkDerived, .write=inner->write, .hash=inner->hash,
+                             .mutate=NULL };
+  return d;
+}
+
+static void QCC_freeDerived(QCC_DerivedValue *d) {
+  int i;
+  if (d->inner) QCC_freeGenValue(d->inner);
+  for (i=0; i<d->sharedN; i++) QCC_release(d->shared[i]);
+  if (d->kind == QCC_DERIVED_TUPLE) QCC_freeAlloc(d->gv.value);
+  QCC_freeAlloc(d->shared);
+  QCC_freeAlloc(d);
+}
+
+QCC_GenValue* QCC_genMap(QCC_GenValue *value, QCC_mapValue map) {
+  QCC_DerivedValue proto = { .kind=QCC_DERIVED_MAP, .map=map };
+  if (!value) return NULL;
+  map(value);
+  return &QCC_newDerived(&proto, value, 0)->gv;
+}
+
+/*
+ * Generate values until one satisfies pred, growing the size by one after
+ * every rejected value if grow is set.
+ */
+static QCC_GenValue* QCC_retry(QCC_gen gen, QCC_predicate pred, int maxTries, QCC_Boolean grow) {
+  QCC_DerivedValue proto = { .kind=QCC_DERIVED_FILTER, .pred=pred };
+  int size = QCC_getSize();
+  int prevSize = QCC_currentSize;
+  int prevEdge = QCC_currentEdge;
+  QCC_GenValue *value = NULL;
+  int i;
+
+  /* Enumerations discard the tuple, rejected values would be chosen again */
+  if (QCC_currentEnum) maxTries = 1;
+  for (i=0; i<maxTries; i++) {
+    if (grow) QCC_setCurrentSize(size + i);
+    /* Edge values rejected once would be drawn again at every try */
+    if (i == 1) QCC_setCurrentEdge(-1);
+    value = gen();
+    QCC_filterTries++;
+    if (value && pred(value)) break;
+    QCC_filterRejects++;
+    QCC_freeGenValue(value);
+    value = NULL;
+  }
+  QCC_setCurrentEdge(prevEdge);
+  QCC_setCurrentSize(prevSize);
+
+  return value ? &QCC_newDerived(&proto, value, 0)->gv : NULL;
+}
+
+QCC_GenValue* QCC_genFilter(QCC_gen gen, QCC_predicate pred) {
+  return QCC_retry(gen, pred, QCC_FILTER_TRIES, QCC_FALSE);
+}
+
+QCC_GenValue* QCC_genSuchThat(QCC_gen gen, QCC_predicate pred, int maxTries) {
+  return QCC_retry(gen, pred, maxTries, QCC_TRUE);
+}
+
+/* Run bind on source with the generator and size of the original result */
+static QCC_GenValue* QCC_bindWith(QCC_bindValue bind, QCC_GenValue *source, uint64_t seed, int size) {
+  QCC_Rng rng, *prevRng;
+  int prevSize = QCC_setCurrentSize(size);
+  /* Shrinking binds again out of the case, hence out of the edge prefix */
+  int prevEdge = QCC_setCurrentEdge(-1);
+  QCC_GenValue *result;
+
+  QCC_rngSeed(&rng, seed);
+  prevRng = QCC_setRng(&rng);
+  result = bind(source);
+  QCC_setRng(prevRng);
+  QCC_setCurrentEdge(prevEdge);
+  QCC_setCurrentSize(prevSize);
+  return result;
+}
+
+QCC_GenValue* QCC_genBind(QCC_GenValue *source, QCC_bindValue bind) {
+  QCC_DerivedValue proto = { .kind=QCC_DERIVED_BIND, .bind=bind,
+                             .seed=QCC_currentEnum ? 0 : QCC_rngNext(QCC_getRng()),
+                             .size=QCC_getSize() };
+  QCC_DerivedValue *d;
+  QCC_GenValue *result;
+
+  if (!source) return NULL;
+  if (!(result = QCC_bindWith(bind, source, proto.seed, proto.size))) {
+    QCC_freeGenValue(source);
+    return NULL;
+  }
+  d = QCC_newDerived(&proto, result, 1);
+  d->shared[0] = QCC_share(source);
+  return &d->gv;
+}
+
+QCC_GenValue* QCC_genOneOf(int genNum, ...) {
+  QCC_gen gen = NULL;
+  va_list genP;
+  int pick, i;
+
+  if (genNum <= 0) return NULL;
+  pick = (int) QCC_choose(genNum);
+  va_start(genP, genNum);
+  for (i=0; i<=pick; i++) gen = va_arg(genP, QCC_gen);
+  va_end(genP);
+  return gen();
+}
+
+QCC_GenValue* QCC_genFrequency(int genNum, ...) {
+  QCC_gen gen = NULL;
+  uint64_t total = 0, weighted = 0, pick;
+  va_list genP;
+  int i, weight;
+
+  va_start(genP, genNum);
+  for (i=0; i<genNum; i++) {
+    weight = va_arg(genP, int);
+    total += weight;
+    weighted += weight > 0;
+    va_arg(genP, QCC_gen);
+  }
+  va_end(genP);
+  if (total == 0) return NULL;
+
+  pick = QCC_currentEnum ? QCC_choose(weighted) : QCC_rngNext(QCC_getRng()) % total;
+  va_start(genP, genNum);
+  for (i=0; i<genNum; i++) {
+    weight = va_arg(genP, int);
+    gen = va_arg(genP, QCC_gen);
+    /* Enumerations choose each generator of nonzero weight once */
+    if (QCC_currentEnum) weight = weight > 0;
+    if (pick < (uint64_t) weight) break;
+    pick -= weight;
+  }
+  va_end(genP);
+  return gen();
+}
+
+static void QCC_writeTuple(QCC_Sink *sink, void *value, int len) {
+  QCC_GenValue **elems = value;
+  int i;
+
+  QCC_sinkWrite(sink, "(", 1);
+  for (i=0; i<len; i++) {
+    if (i) QCC_sinkWrite(sink, ", ", 2);
+    QCC_writeGenValue(sink, elems[i]);
+  }
+  QCC_sinkWrite(sink, ")", 1);
+}
+
+static char* QCC_showTuple(void *value, int len) {
+  return QCC_showWritten(QCC_writeTuple, value, len);
+}
+
+static uint64_t QCC_hashTuple(void *value, int len) {
+  QCC_GenValue **elems = value;
+  uint64_t h = (uint64_t) len;
+  int i;
+
+  for (i=0; i<len; i++) h = QCC_hashMix(h, QCC_hashGenValue(elems[i]));
+  return h;
+}
+
+/* Tuple of the shared elements, which the tuple takes a reference to */
+static QCC_GenValue* QCC_newTuple(QCC_SharedValue **elems, int n) {
+  QCC_DerivedValue proto = { .kind=QCC_DERIVED_TUPLE };
+  QCC_DerivedValue *d = QCC_newDerived(&proto, NULL, n);
+  QCC_GenValue **values = QCC_alloc(sizeof(QCC_GenValue *) * (n ? n : 1));
+  int i;
+
+  for (i=0; i<n; i++) {
+    d->shared[i] = elems[i];
+    elems[i]->refs++;
+    values[i] = elems[i]->value;
+  }
+  d->gv = (QCC_GenValue) { .value=values, .n=n, .show=QCC_showTuple, .free=QCC_freeAlloc,
+                           .shrink=QCC_shrinkDerived, .write=QCC_writeTuple, .hash=QCC_hashTuple,
+                           .mutate=NULL };
+  return &d->gv;
+}
+
+QCC_GenValue* QCC_genTuple(int genNum, ...) {
+  QCC_SharedValue **elems = QCC_alloc(sizeof(QCC_SharedValue *) * (genNum ? genNum : 1));
+  QCC_GenValue *tuple = NULL, *value;
+  va_list genP;
+  int i, n;
+
+  va_start(genP, genNum);
+  for (n=0; n<genNum; n++) {
+    if (!(value = va_arg(genP, QCC_gen)())) break;
+    elems[n] = QCC_share(value);
+  }
+  va_end(genP);
+
+  if (n == genNum) tuple = QCC_newTuple(elems, n);
+  for (i=0; i<n; i++) QCC_release(elems[i]);
+  QCC_freeAlloc(elems);
+  return tuple;
+}
+
+static QCC_GenValue* QCC_derivedPart(QCC_DerivedValue *d, int part) {
+  switch (d->kind) {
+  case QCC_DERIVED_BIND: return part == 0 ? d->shared[0]->value : (part == 1 ? d->inner : NULL);
+  case QCC_DERIVED_TUPLE: return part < d->sharedN ? d->shared[part]->value : NULL;
+  default: return part == 0 ? d->inner : NULL;
+  }
+}
+
+/*
+ * Rebuild the derived value d with the candidate c of one of its parts,
+ * NULL if the candidate is rejected. c is taken over in any case.
+ */
+static QCC_GenValue* QCC_rebuildDerived(QCC_DerivedValue *d, int part, QCC_GenValue *c) {
+  QCC_DerivedValue *r;
+  QCC_GenValue *result, *tuple;
+
+  switch (d->kind) {
+  case QCC_DERIVED_MAP:
+    d->map(c);
+    return &QCC_newDerived(d, c, 0)->gv;
+  case QCC_DERIVED_FILTER:
+    if (d->pred(c)) return &QCC_newDerived(d, c, 0)->gv;
+    QCC_freeGenValue(c);
+    return NULL;
+  case QCC_DERIVED_BIND:
+    if (part == 1) {
+      r = QCC_newDerived(d, c, 1);
+      r->shared[0] = d->shared[0];
+      r->shared[0]->refs++;
+      return &r->gv;
+    }
+    if (!(result = QCC_bindWith(d->bind, c, d->seed, d->size))) {
+      QCC_freeGenValue(c);
+      return NULL;
+    }
+    r = QCC_newDerived(d, result, 1);
+    r->shared[0] = QCC_share(c);
+    return &r->gv;
+  case QCC_DERIVED_TUPLE: {
+    QCC_SharedValue *prev = d->shared[part];
+    d->shared[part] = QCC_share(c);
+    tuple = QCC_newTuple(d->shared, d->sharedN);
+    QCC_release(d->shared[part]);
+    d->shared[part] = prev;
+    return tuple;
+  }
+  }
+  return NULL;
+}
+
+static QCC_GenValue* QCC_shrinkDerived(QCC_GenValue *gv, int idx) {
+  QCC_DerivedValue *d = (QCC_DerivedValue *) gv;
+  QCC_GenValue *part, *c;
+
+  if (idx <= d->lastIdx) {
+    d->lastIdx = -1;
+    d->part = d->partIdx = 0;
+  }
+  while ((part = QCC_derivedPart(d, d->part))) {
+    if (!part->shrink || !(c = part->shrink(part, d->partIdx))) {
+      d->part++;
+      d->partIdx = 0;
+      continue;
+    }
+    d->partIdx++;
+    if (!(c = QCC_rebuildDerived(d, d->part, c))) continue;
+    if (++d->lastIdx == idx) return c;
+    QCC_freeGenValue(c);
+  }
+  return NULL;
+}
+
+/***********************************************************************
+ *  Convenience functions
+ ***********************************************************************/
+QCC_TestStatus QCC_not(QCC_TestStatus propStatus) {
+  switch (propStatus) {
+  case QCC_OK: return QCC_FAIL;
+  case QCC_FAIL: return QCC_OK;
+  case QCC_NOTHING: return QCC_NOTHING;
+  default: return QCC_FAIL;
+  }
+}
+
+QCC_TestStatus QCC_and(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
+  switch (prop1Status) {
+  case QCC_OK: return prop2Status;
+  case QCC_FAIL: return QCC_FAIL;
+  case QCC_NOTHING: return QCC_NOTHING;
+  default: return QCC_FAIL;
+  }
+}
+
+QCC_TestStatus QCC_or(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
+  switch (prop1Status) {
+  case QCC_OK: return QCC_OK;
+  case QCC_FAIL:
+  case QCC_NOTHING:
+    return prop2Status;
+  default: return QCC_FAIL;
+  }
+}
+
+QCC_TestStatus QCC_xor(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status) {
+  switch (prop1Status) {
+  case QCC_OK: return QCC_not(prop2Status);
+  case QCC_FAIL: return prop2Status;
+  case QCC_NOTHING: return QCC_NOTHING;
+  default: return QCC_FAIL;
+  }
+}
+
+/***********************************************************************
+ *  Profiling
+ ***********************************************************************/
+
+/*
+ * With QCC_PROFILE defined the plan runners time each phase of a case
+ * (ticks are TSC cycles on x86, nanoseconds elsewhere) into counters owned
+ * by the plan, which are folded into the global profile when the plan is
+ * released. Without it the macros below expand to nothing.
+ */
+#ifdef QCC_PROFILE
+enum QCC_ProfilePhase {
+  QCC_PHASE_GENERATE, QCC_PHASE_EVALUATE, QCC_PHASE_LABEL,
+  QCC_PHASE_FREE, QCC_PHASE_SHOW, QCC_PHASE_SHRINK, QCC_PHASES
+};
+
+static const char *QCC_phaseNames[QCC_PHASES] = {
+  "generate", "evaluate", "label", "free", "show", "shrink"
+};
+
+typedef struct QCC_ProfileCounter {
+  uint64_t calls;
+  uint64_t ticks;
+} QCC_ProfileCounter;
+
+typedef struct QCC_ProfileEntry {
+  void *fn;
+  int isProperty;
+  QCC_ProfileCounter phases[QCC_PHASES];
+  struct QCC_ProfileEntry *next;
+} QCC_ProfileEntry;
+
+static pthread_mutex_t QCC_profileLock = PTHREAD_MUTEX_INITIALIZER;
+static QCC_ProfileEntry *QCC_profileHead = NULL;
+static QCC_ProfileEntry **QCC_profileTail = &QCC_profileHead;
+
+/* Ticks spent in QCC_label by the current thread, split off evaluation */
+static _Thread_local uint64_t QCC_profileLabelTicks = 0;
+
+static inline uint64_t QCC_profileTicks() {
+#ifdef QCC_PROFILE_TSC
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t QCC_profileLap(QCC_ProfileCounter *c, uint64_t start) {
+  uint64_t now = QCC_profileTicks();
+  c->calls++;
+  c->ticks += now - start;
+  return now;
+}
+
+static void QCC_profileAccount(void *fn, int isProperty, QCC_ProfileCounter *phases, int phasesN) {
+  QCC_ProfileEntry *e;
+  int i;
+
+  for (e=QCC_profileHead; e; e=e->next)
+    if (e->fn == fn && e->isProperty == isProperty) break;
+  if (!e) {
+    e = calloc(1, sizeof(QCC_ProfileEntry));
+    e->fn = fn;
+    e->isProperty = isProperty;
+    *QCC_profileTail = e;
+    QCC_profileTail = &e->next;
+  }
+  for (i=0; i<phasesN; i++) {
+    e->phases[i].calls += phases[i].calls;
+    e->phases[i].ticks += phases[i].ticks;
+  }
+}
+
+/* Nanoseconds per tick, measured against the monotonic clock */
+static double QCC_profileTickNs() {
+#ifdef QCC_PROFILE_TSC
+  struct timespec req = { .tv_sec=0, .tv_nsec=10000000 }, a, b;
+  uint64_t ta, tb;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  ta = __rdtsc();
+  nanosleep(&req, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  tb = __rdtsc();
+  return ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / (double) (tb - ta);
+#else
+  return 1.0;
+#endif
+}
+
+static void QCC_profileName(void *fn, char *buf, size_t size) {
+  Dl_info info;
+  if (dladdr(fn, &info) && info.dli_sname && info.dli_saddr == fn)
+    snprintf(buf, size, "%s", info.dli_sname);
+  else
+    snprintf(buf, size, "%p", fn);
+}
+
+#define QCC_PROFILE_START(t) uint64_t t = QCC_profileTicks()
+#define QCC_PROFILE_LAP(counter, t) (t = QCC_profileLap(&(counter), t))
+#else
+#define QCC_PROFILE_START(t)
+#define QCC_PROFILE_LAP(counter, t)
+#endif
+
+void QCC_printProfile() {
+#ifdef QCC_PROFILE
+  char name[256];
+  double tickNs = QCC_profileTickNs();
+  QCC_ProfileEntry *e;
+  int i;
+
+  pthread_mutex_lock(&QCC_profileLock);
+  for (e=QCC_profileHead; e; e=e->next) {
+    QCC_profileName(e->fn, name, sizeof(name));
+    printf("%s %s\n", e->isProperty ? "Property" : "Generator", name);
+    for (i=0; i<QCC_PHASES; i++) {
+      QCC_ProfileCounter *c = &e->phases[i];
+      if (!c->calls) continue;
+      printf("  %-9s %10llu calls %12.3f ms %10.1f ns/call %10.1f ticks/call\n",
+             QCC_phaseNames[i], (unsigned long long) c->calls, c->ticks * tickNs / 1e6,
+             c->ticks * tickNs / c->calls, (double) c->ticks / c->calls);
+    }
+  }
+  pthread_mutex_unlock(&QCC_profileLock);
+#else
+  printf("Profiling disabled (compile with -DQCC_PROFILE)\n");
+#endif
+}
+
+int QCC_exportProfile(const char *path) {
+#ifdef QCC_PROFILE
+  char name[256];
+  double tickNs = QCC_profileTickNs();
+  QCC_ProfileEntry *e;
+  int i;
+
+  FILE *f = fopen(path, "w");
+  if (!f) return -1;
+  fprintf(f, "kind,name,phase,calls,ticks,ns\n");
+  pthread_mutex_lock(&QCC_profileLock);
+  for (e=QCC_profileHead; e; e=e->next) {
+    QCC_profileName(e->fn, name, sizeof(name));
+    for (i=0; i<QCC_PHASES; i++) {
+      QCC_ProfileCounter *c = &e->phases[i];
+      if (!c->calls) continue;
+      fprintf(f, "%s,%s,%s,%llu,%llu,%.0f\n", e->isProperty ? "property" : "generator",
+              name, QCC_phaseNames[i], (unsigned long long) c->calls,
+              (unsigned long long) c->ticks, c->ticks * tickNs);
+    }
+  }
+  pthread_mutex_unlock(&QCC_profileLock);
+  return fclose(f) ? -1 : 0;
+#else
+  return -1;
+#endif
+}
+
+void QCC_resetProfile() {
+#ifdef QCC_PROFILE
+  pthread_mutex_lock(&QCC_profileLock);
+  while (QCC_profileHead) {
+    QCC_ProfileEntry *next = QCC_profileHead->next;
+    free(QCC_profileHead);
+    QCC_profileHead = next;
+  }
+  QCC_profileTail = &QCC_profileHead;
+  pthread_mutex_unlock(&QCC_profileLock);
+#endif
+}
+
+/***********************************************************************
+ *  Categorization function
+ ***********************************************************************/
+static uint64_t QCC_hashLabel(const char *label) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (; *label; label++) h = (h ^ (uint8_t) *label) * 0x100000001b3ULL;
+  return h;
+}
+
+static QCC_Stamp* QCC_newStamp() {
+  QCC_Stamp *st = malloc(sizeof(QCC_Stamp));
+  *st = (QCC_Stamp) { .entries=NULL, .entriesN=0, .entriesCap=0,
+                      .slots=NULL, .slotsCap=0, .touched=NULL, .touchedN=0, .linked=NULL };
+  return st;
+}
+
+void QCC_freeStamp(QCC_Stamp *stamps) {
+  int i;
+  if (!stamps) return;
+  for (i=0; i<stamps->entriesN; i++) free(stamps->entries[i].label);
+  free(stamps->entries);
+  free(stamps->slots);
+  free(stamps->touched);
+  free(stamps);
+}
+
+static void QCC_resetStamp(QCC_Stamp *stamps) {
+  int i;
+  if (!stamps) return;
+  for (i=0; i<stamps->touchedN; i++) stamps->entries[stamps->touched[i]].n = 0;
+  stamps->touchedN = 0;
+}
+
+static void QCC_growStamp(QCC_Stamp *stamps) {
+  int i, j;
+
+  if (stamps->entriesN == stamps->entriesCap) {
+    stamps->entriesCap = stamps->entriesCap ? 2*stamps->entriesCap : 8;
+    stamps->entries = realloc(stamps->entries, sizeof(QCC_StampEntry) * stamps->entriesCap);
+    stamps->touched = realloc(stamps->touched, sizeof(int) * stamps->entriesCap);
+  }
+
+  if (2*(stamps->entriesN+1) > stamps->slotsCap) {
+    stamps->slotsCap = stamps->slotsCap ? 2*stamps->slotsCap : 16;
+    stamps->slots = realloc(stamps->slots, sizeof(int) * stamps->slotsCap);
+    for (j=0; j<stamps->slotsCap; j++) stamps->slots[j] = -1;
+    for (i=0; i<stamps->entriesN; i++) {
+      j = stamps->entries[i].hash & (stamps->slotsCap-1);
+      while (stamps->slots[j] >= 0) j = (j+1) & (stamps->slotsCap-1);
+      stamps->slots[j] = i;
+    }
+  }
+}
+
+/* Index of the entry for label, which is added if missing */
+static int QCC_findLabel(QCC_Stamp *stamps, const char *label, uint64_t hash) {
+  int j;
+
+  if (stamps->slotsCap) {
+    for (j = hash & (stamps->slotsCap-1); stamps->slots[j] >= 0; j = (j+1) & (stamps->slotsCap-1)) {
+      QCC_StampEntry *e = &stamps->entries[stamps->slots[j]];
+      if (e->hash == hash && strcmp(e->label, label) == 0) return stamps->slots[j];
+    }
+  }
+
+  QCC_growStamp(stamps);
+  for (j = hash & (stamps->slotsCap-1); stamps->slots[j] >= 0; j = (j+1) & (stamps->slotsCap-1));
+  stamps->slots[j] = stamps->entriesN;
+  stamps->entries[stamps->entriesN] = (QCC_StampEntry) { .label=strdup(label), .hash=hash, .n=0, .link=-1 };
+  return stamps->entriesN++;
+}
+
+static void QCC_labelN(QCC_Stamp *stamps, int idx, int n) {
+  if (stamps->entries[idx].n == 0) stamps->touched[stamps->touchedN++] = idx;
+  stamps->entries[idx].n += n;
+}
+
+void QCC_label(QCC_Stamp **stamps, char *label) {
+#ifdef QCC_PROFILE
+  uint64_t start = QCC_profileTicks();
+#endif
+  if (!*stamps) *stamps = QCC_newStamp();
+  QCC_labelN(*stamps, QCC_findLabel(*stamps, label, QCC_hashLabel(label)), 1);
+#ifdef QCC_PROFILE
+  QCC_profileLabelTicks += QCC_profileTicks() - start;
+#endif
+}
+
+/*
+ * Add the labels of src to dst. The labels of a case count once however
+ * many times the case added them, as reports give the share of the cases
+ * having each label; the totals of runs add up.
+ */
+static void QCC_mergeLabels(QCC_Stamp **dst, QCC_Stamp *src, QCC_Boolean perCase) {
+  int i;
+
+  if (!src || !src->touchedN) return;
+  if (!*dst) *dst = QCC_newStamp();
+  if (src->linked != *dst) {
+    for (i=0; i<src->entriesN; i++) src->entries[i].link = -1;
+    src->linked = *dst;
+  }
+
+  for (i=0; i<src->touchedN; i++) {
+    QCC_StampEntry *e = &src->entries[src->touched[i]];
+    if (e->link < 0) e->link = QCC_findLabel(*dst, e->label, e->hash);
+    QCC_labelN(*dst, e->link, perCase ? 1 : e->n);
+  }
+}
+
+/* Most frequent labels first, ties in order of first appearance */
+static int QCC_compareStampEntries(const void *a, const void *b) {
+  const QCC_StampEntry *e1 = *(const QCC_StampEntry **) a;
+  const QCC_StampEntry *e2 = *(const QCC_StampEntry **) b;
+  if (e1->n != e2->n) return e2->n - e1->n;
+  return e1 < e2 ? -1 : (e1 > e2);
+}
+
+static QCC_StampEntry** QCC_sortStamp(QCC_Stamp *stamps, int *n) {
+  QCC_StampEntry **sorted;
+  int i;
+
+  *n = stamps ? stamps->touchedN : 0;
+  if (!*n) return NULL;
+  sorted = malloc(sizeof(QCC_StampEntry *) * *n);
+  for (i=0; i<*n; i++) sorted[i] = &stamps->entries[stamps->touched[i]];
+  qsort(sorted, *n, sizeof(QCC_StampEntry *), QCC_compareStampEntries);
+  return sorted;
+}
+
+/***********************************************************************
+ *  Testing functions
+ ***********************************************************************/
+void QCC_freeGenValue(QCC_GenValue *value) {
+  if (!value) return;
+  if (value->shrink == QCC_shrinkDerived) {
+    QCC_freeDerived((QCC_DerivedValue *) value);
+  } else {
+    value->free(value->value);
+    QCC_freeAlloc(value);
+  }
+}
+
+void QCC_freeGenValues(QCC_GenValue **arguments, int argumentsN) {
+  int i;
+  for (i=0; i<argumentsN; i++) QCC_freeGenValue(arguments[i]);
+  if (arguments) QCC_freeAlloc(arguments);
+}
+
+void QCC_freeResult(QCC_Result *res) {
+  QCC_freeStamp(res->stamps);
+  QCC_freeGenValues(res->arguments, res->argumentsN);
+}
+
+QCC_Result QCC_vforAll(QCC_property prop, int genNum, va_list genP) { //QCC_gen *genLst,
+  QCC_GenValue **vals = NULL;
+  if (genNum) {
+    int i;
+    vals = QCC_alloc(sizeof(QCC_GenValue*) * genNum);
+    for (i=0; i<genNum; i++) {
+      QCC_gen gen = va_arg(genP, QCC_gen);
+      vals[i] = gen();
+    }
+  }
+
+  /* A generator returning NULL discards the case */
+  QCC_Stamp *stamps = NULL;
+  QCC_TestStatus status = QCC_NOTHING;
+  int i;
+  for (i=0; i<genNum && vals[i]; i++);
+  if (i == genNum) status = prop(vals, genNum, &stamps);
+  return (QCC_Result) {
+    .status = status,
+      .stamps = stamps,
+      .arguments = vals,
+      .argumentsN = genNum
+      };
+}
+
+QCC_Result QCC_forAll(QCC_property prop, int genNum, ...) { //QCC_gen *genLst,
+  va_list genP;
+  QCC_Result res;
+  va_start(genP, genNum);
+  res = QCC_vforAll(prop, genNum, genP);
+  va_end(genP);
+  return res;
+}
+
+static void QCC_printStamps(QCC_Stamp *stamps, int n) {
+  int sortedN, i;
+  QCC_StampEntry **sorted = QCC_sortStamp(stamps, &sortedN);
+  for (i=0; i<sortedN; i++)
+    QCC_reportf("%.2f%%\t%s\n", (sorted[i]->n/(float)n)*100, sorted[i]->label);
+  free(sorted);
+}
+
+static void QCC_printArguments(QCC_GenValue **arguments, int argumentsN) {
+  QCC_Sink stdoutSink;
+  QCC_Sink *sink = QCC_reportSink;
+  int prevMaxElems, i;
+
+  if (!sink) {
+    QCC_initFileSink(&stdoutSink, stdout);
+    sink = &stdoutSink;
+  }
+  prevMaxElems = sink->maxElems;
+  sink->maxElems = QCC_showMaxElems;
+  for (i=0; i<argumentsN; i++) {
+    QCC_writeGenValue(sink, arguments[i]);
+    QCC_sinkWrite(sink, "\n", 1);
+  }
+  sink->maxElems = prevMaxElems;
+}
+
+/***********************************************************************
+ *  Shrinking functions
+ ***********************************************************************/
+static int QCC_shrinkMaxSteps = 1000;
+static double QCC_shrinkMaxSeconds = 1.0;
+
+typedef struct QCC_ShrinkStats {
+  int shrinks;
+  int steps;
+  double seconds;
+  QCC_Boolean exhausted;
+} QCC_ShrinkStats;
+
+void QCC_setShrinkBudget(int maxSteps, double maxSeconds) {
+  QCC_shrinkMaxSteps = maxSteps;
+  QCC_shrinkMaxSeconds = maxSeconds;
+}
+
+static double QCC_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Greedily minimize the falsifying arguments of res: each argument is
+ * replaced by its first shrink candidate which still falsifies the
+ * property, restarting from the simplest candidate after every success.
+ * Passes over all the arguments are repeated until none of them shrinks
+ * any further or the budget is exhausted.
+ */
+static QCC_ShrinkStats QCC_shrinkResult(QCC_property prop, QCC_Result *res) {
+  QCC_ShrinkStats stats = { .shrinks=0, .steps=0, .seconds=0, .exhausted=QCC_FALSE };
+  QCC_Stamp *stamps = NULL;
+  double start = QCC_now();
+  int progress = 1;
+  int i, idx;
+
+  while (progress && !stats.exhausted) {
+    progress = 0;
+    for (i=0; i<res->argumentsN && !stats.exhausted; i++) {
+      QCC_GenValue *arg = res->arguments[i];
+      if (!arg->shrink) continue;
+
+      for (idx=0; ; idx++) {
+        if (stats.steps >= QCC_shrinkMaxSteps ||
+            (QCC_shrinkMaxSeconds > 0 && QCC_now() - start >= QCC_shrinkMaxSeconds)) {
+          stats.exhausted = QCC_TRUE;
+          break;
+        }
+
+        QCC_GenValue *candidate = arg->shrink(arg, idx);
+        if (!candidate) break;
+
+        QCC_resetStamp(stamps);
+        res->arguments[i] = candidate;
+        QCC_TestStatus status = prop(res->arguments, res->argumentsN, &stamps);
+        stats.steps++;
+
+        if (status == QCC_FAIL) {
+          QCC_freeGenValue(arg);
+          arg = candidate;
+          stats.shrinks++;
+          progress = 1;
+          idx = -1;
+        } else {
+          res->arguments[i] = arg;
+          QCC_freeGenValue(candidate);
+        }
+      }
+    }
+  }
+
+  QCC_freeStamp(stamps);
+  stats.seconds = QCC_now() - start;
+  return stats;
+}
+
+/***********************************************************************
+ *  Test plans
+ ***********************************************************************/
+/*
+ * Generation work thrown away: cases discarded because a generator
+ * returned NULL or because they repeated an earlier case, and values
+ * generated and rejected by filters.
+ */
+typedef struct QCC_DiscardStats {
+  int generators;
+  int duplicates;
+  uint64_t filterTries;
+  uint64_t filterRejects;
+} QCC_DiscardStats;
+
+static void QCC_addDiscards(QCC_DiscardStats *dst, QCC_DiscardStats *src) {
+  dst->generators += src->generators;
+  dst->duplicates += src->duplicates;
+  dst->filterTries += src->filterTries;
+  dst->filterRejects += src->filterRejects;
+}
+
+/*
+ * Fingerprints of the cases run by a plan, in a linear probing table kept
+ * at most half full (0 marks empty slots). The table doubles up to
+ * QCC_dedupSlots slots; once that full it is cleared, so memory stays
+ * bounded on long runs at the price of running some old cases again.
+ */
+#define QCC_DEDUP_MIN_SLOTS 1024
+
+static size_t QCC_dedupSlots = 0;
+
+typedef struct QCC_CaseSet {
+  uint64_t *slots;
+  size_t size;
+  size_t used;
+} QCC_CaseSet;
+
+void QCC_setDedup(int maxCases) {
+  size_t slots = QCC_DEDUP_MIN_SLOTS;
+
+  if (maxCases <= 0) {
+    QCC_dedupSlots = 0;
+    return;
+  }
+  while (slots < 2 * (size_t) maxCases) slots *= 2;
+  QCC_dedupSlots = slots;
+}
+
+static void QCC_freeCaseSet(QCC_CaseSet *set) {
+  free(set->slots);
+  *set = (QCC_CaseSet) { .slots=NULL, .size=0, .used=0 };
+}
+
+/* Store h unless already there, returns whether it was */
+static QCC_Boolean QCC_caseSetInsert(QCC_CaseSet *set, uint64_t h) {
+  size_t mask = set->size - 1, i;
+
+  for (i=h & mask; set->slots[i]; i=(i + 1) & mask)
+    if (set->slots[i] == h) return QCC_TRUE;
+  set->slots[i] = h;
+  set->used++;
+  return QCC_FALSE;
+}
+
+/* Double the slots of set, or clear it if it has maxSlots already */
+static void QCC_growCaseSet(QCC_CaseSet *set, size_t maxSlots) {
+  QCC_CaseSet old = *set;
+  size_t i;
+
+  if (maxSlots && old.size >= maxSlots) {
+    memset(set->slots, 0, sizeof(uint64_t) * set->size);
+    set->used = 0;
+    return;
+  }
+  set->size = old.size ? old.size * 2 : QCC_DEDUP_MIN_SLOTS;
+  set->slots = calloc(set->size, sizeof(uint64_t));
+  set->used = 0;
+  for (i=0; i<old.size; i++)
+    if (old.slots[i]) QCC_caseSetInsert(set, old.slots[i]);
+  free(old.slots);
+}
+
+/* Record the fingerprint of the arguments of vals, returns whether it was seen already */
+static QCC_Boolean QCC_seenCase(QCC_CaseSet *set, QCC_GenValue **vals, int n) {
+  uint64_t h = (uint64_t) n;
+  int i;
+
+  for (i=0; i<n; i++) h = QCC_hashMix(h, QCC_hashGenValue(vals[i]));
+  h = QCC_splitMix64(&h);
+  if (!h) h = 1;
+  if (set->used * 2 >= set->size) QCC_growCaseSet(set, QCC_dedupSlots);
+  return QCC_caseSetInsert(set, h);
+}
+
+struct QCC_Plan {
+  QCC_property prop;
+  int genNum;
+  QCC_gen *gens;
+  QCC_GenValue **vals;
+  QCC_Boolean generated;
+  QCC_Stamp *caseStamps;
+  QCC_Stamp *stamps;
+  QCC_Arena *arena;
+  QCC_TestStatus status;
+  int succ;
+  int fail;
+  QCC_DiscardStats discards;
+  char crash[96];
+  QCC_Boolean isolated;
+  char *name;
+  uint64_t runSeed;
+  uint64_t cases;
+  uint64_t seed;
+  int size;
+  int edge;
+  int64_t caseIndex;
+  int lane;
+  QCC_Boolean enumerated;
+  QCC_CaseSet seen;
+#ifdef QCC_PROFILE
+  QCC_ProfileCounter profile[QCC_PHASES];
+  QCC_ProfileCounter *genProfile;
+#endif
+};
+
+/*
+ * A case is generated from its seed at its size, drawing only edge values
+ * if it belongs to the edge prefix of its run (edge >= 0).
+ */
+typedef struct QCC_Case {
+  uint64_t seed;
+  int size;
+  int edge;
+} QCC_Case;
+
+static QCC_Case QCC_indexCase(uint64_t runSeed, uint64_t caseIndex) {
+  return (QCC_Case) { .seed=QCC_caseSeed(runSeed, caseIndex), .size=QCC_caseSize(caseIndex),
+                      .edge=QCC_caseEdge(caseIndex) };
+}
+
+static QCC_Plan* QCC_allocPlan(QCC_property prop, int genNum) {
+  QCC_Plan *plan = malloc(sizeof(QCC_Plan));
+  *plan = (QCC_Plan) { .prop=prop, .genNum=genNum, .generated=QCC_FALSE,
+                       .caseStamps=NULL, .stamps=NULL, .arena=QCC_newArena(),
+                       .status=QCC_OK, .succ=0, .fail=0, .discards={ 0, 0, 0, 0 }, .crash="", .isolated=QCC_FALSE,
+                       .name=NULL, .runSeed=QCC_rngNext(QCC_getRng()), .cases=0, .seed=0, .size=0, .edge=-1, .caseIndex=-1, .lane=-1,
+                       .enumerated=QCC_FALSE, .seen={ NULL, 0, 0 } };
+
+  /* Argument storage is allocated once and reused by every case */
+  plan->gens = malloc(sizeof(QCC_gen) * (genNum ? genNum : 1));
+  plan->vals = malloc(sizeof(QCC_GenValue *) * (genNum ? genNum : 1));
+#ifdef QCC_PROFILE
+  memset(plan->profile, 0, sizeof(plan->profile));
+  plan->genProfile = calloc(genNum ? genNum : 1, sizeof(QCC_ProfileCounter));
+#endif
+  return plan;
+}
+
+QCC_Plan* QCC_newPlan(QCC_property prop, int genNum, QCC_gen *gens) {
+  QCC_Plan *plan = QCC_allocPlan(prop, genNum);
+  if (genNum) memcpy(plan->gens, gens, sizeof(QCC_gen) * genNum);
+  return plan;
+}
+
+static QCC_Plan* QCC_vnewPlan(QCC_property prop, int genNum, va_list genP) {
+  QCC_Plan *plan = QCC_allocPlan(prop, genNum);
+  int i;
+  for (i=0; i<genNum; i++) plan->gens[i] = va_arg(genP, QCC_gen);
+  return plan;
+}
+
+/* Must be called with the plan arena installed */
+static void QCC_clearPlanValues(QCC_Plan *plan) {
+  int i;
+  if (!plan->generated) return;
+  QCC_PROFILE_START(t);
+  for (i=0; i<plan->genNum; i++) QCC_freeGenValue(plan->vals[i]);
+  plan->generated = QCC_FALSE;
+  QCC_PROFILE_LAP(plan->profile[QCC_PHASE_FREE], t);
+}
+
+static void QCC_resetPlan(QCC_Plan *plan) {
+  QCC_Arena *prevArena = QCC_useArena(plan->arena);
+  QCC_clearPlanValues(plan);
+  QCC_useArena(prevArena);
+
+  QCC_resetStamp(plan->stamps);
+  plan->status = QCC_OK;
+  plan->succ = 0;
+  plan->fail = 0;
+  plan->discards = (QCC_DiscardStats) { 0, 0, 0, 0 };
+  plan->crash[0] = '\0';
+  plan->isolated = QCC_FALSE;
+  plan->runSeed = QCC_rngNext(QCC_getRng());
+  plan->cases = 0;
+  QCC_freeCaseSet(&plan->seen);
+}
+
+void QCC_freePlan(QCC_Plan *plan) {
+#ifdef QCC_PROFILE
+  int i;
+#endif
+  QCC_Arena *prevArena = QCC_useArena(plan->arena);
+  QCC_clearPlanValues(plan);
+  QCC_useArena(prevArena);
+
+#ifdef QCC_PROFILE
+  pthread_mutex_lock(&QCC_profileLock);
+  QCC_profileAccount(plan->prop, 1, plan->profile, QCC_PHASES);
+  for (i=0; i<plan->genNum; i++)
+    if (plan->gens[i]) QCC_profileAccount(plan->gens[i], 0, &plan->genProfile[i], 1);
+  pthread_mutex_unlock(&QCC_profileLock);
+  free(plan->genProfile);
+#endif
+
+  QCC_freeArena(plan->arena);
+  QCC_freeCaseSet(&plan->seen);
+  QCC_freeStamp(plan->caseStamps);
+  QCC_freeStamp(plan->stamps);
+  free(plan->name);
+  free(plan->gens);
+  free(plan->vals);
+  free(plan);
+}
+
+void QCC_setPlanName(QCC_Plan *plan, const char *name) {
+  free(plan->name);
+  plan->name = name ? strdup(name) : NULL;
+}
+
+/* Evaluate the property on the generated arguments of plan */
+static void QCC_planEvaluate(QCC_Plan *plan) {
+  QCC_resetStamp(plan->caseStamps);
+#ifdef QCC_PROFILE
+  uint64_t labelTicks = QCC_profileLabelTicks;
+#endif
+  QCC_PROFILE_START(t);
+  plan->status = plan->prop(plan->vals, plan->genNum, &plan->caseStamps);
+#ifdef QCC_PROFILE
+  /* Time spent in QCC_label is accounted to the label phase */
+  labelTicks = QCC_profileLabelTicks - labelTicks;
+  QCC_PROFILE_LAP(plan->profile[QCC_PHASE_EVALUATE], t);
+  plan->profile[QCC_PHASE_EVALUATE].ticks -= labelTicks;
+  plan->profile[QCC_PHASE_LABEL].ticks += labelTicks;
+#endif
+  if (plan->status == QCC_OK) {
+    plan->succ++;
+    QCC_mergeLabels(&plan->stamps, plan->caseStamps, QCC_TRUE);
+    QCC_PROFILE_LAP(plan->profile[QCC_PHASE_LABEL], t);
+  } else if (plan->status == QCC_NOTHING) {
+    plan->fail++;
+  }
+}
+
+/*
+ * Run the case c. The generator, size and edge prefix index of the current
+ * thread are replaced for the whole case, so that the case only depends on
+ * them.
+ */
+static QCC_TestStatus QCC_planStepCase(QCC_Plan *plan, QCC_Case c) {
+  QCC_Arena *prevArena = QCC_useArena(plan->arena);
+  QCC_Rng rng;
+  QCC_Rng *prevRng;
+  int prevSize, prevEdge;
+  int i;
+
+  plan->seed = c.seed;
+  plan->size = c.size;
+  plan->edge = c.edge;
+  plan->caseIndex = -1;
+  plan->enumerated = QCC_FALSE;
+  QCC_rngSeed(&rng, c.seed);
+  prevRng = QCC_setRng(&rng);
+  prevSize = QCC_setCurrentSize(c.size);
+  prevEdge = QCC_setCurrentEdge(c.edge);
+  QCC_edgeDraws = 0;
+  QCC_clearPlanValues(plan);
+  QCC_resetArena(plan->arena);
+
+  uint64_t filterTries = QCC_filterTries, filterRejects = QCC_filterRejects;
+  QCC_PROFILE_START(t);
+  for (i=0; i<plan->genNum; i++) {
+    QCC_PROFILE_START(g);
+    plan->vals[i] = plan->gens[i]();
+    QCC_PROFILE_LAP(plan->genProfile[i], g);
+  }
+  plan->generated = QCC_TRUE;
+  QCC_PROFILE_LAP(plan->profile[QCC_PHASE_GENERATE], t);
+  plan->discards.filterTries += QCC_filterTries - filterTries;
+  plan->discards.filterRejects += QCC_filterRejects - filterRejects;
+
+  for (i=0; i<plan->genNum && plan->vals[i]; i++);
+  if (i < plan->genNum) {
+    /* A generator returning NULL discards the case */
+    plan->status = QCC_NOTHING;
+    plan->fail++;
+    plan->discards.generators++;
+  } else if (QCC_dedupSlots && QCC_seenCase(&plan->seen, plan->vals, plan->genNum)) {
+    /* The same arguments were tested already */
+    plan->status = QCC_NOTHING;
+    plan->fail++;
+    plan->discards.duplicates++;
+  } else {
+    QCC_planEvaluate(plan);
+  }
+
+  QCC_setCurrentEdge(prevEdge);
+  QCC_setCurrentSize(prevSize);
+  QCC_setRng(prevRng);
+  QCC_useArena(prevArena);
+  return plan->status;
+}
+
+QCC_TestStatus QCC_planStep(QCC_Plan *plan) {
+  QCC_TestStatus status = QCC_planStepCase(plan, QCC_indexCase(plan->runSeed, plan->cases));
+  plan->caseIndex = plan->cases++;
+  return status;
+}
+
+QCC_GenValue** QCC_planArguments(QCC_Plan *plan) {
+  return plan->generated ? plan->vals : NULL;
+}
+
+/*
+ * Generate the arguments of the case c in vals, replacing the generator,
+ * size and edge prefix index of the current thread meanwhile. Returns
+ * whether all the generators returned a value.
+ */
+static QCC_Boolean QCC_generateCase(QCC_gen *gens, int genNum, QCC_Case c, QCC_GenValue **vals) {
+  QCC_Rng rng;
+  QCC_Rng *prevRng;
+  int prevSize, prevEdge;
+  int i, generated = 0;
+
+  QCC_rngSeed(&rng, c.seed);
+  prevRng = QCC_setRng(&rng);
+  prevSize = QCC_setCurrentSize(c.size);
+  prevEdge = QCC_setCurrentEdge(c.edge);
+  QCC_edgeDraws = 0;
+  for (i=0; i<genNum; i++) generated += (vals[i] = gens[i]()) != NULL;
+  QCC_setCurrentEdge(prevEdge);
+  QCC_setCurrentSize(prevSize);
+  QCC_setRng(prevRng);
+  return generated == genNum;
+}
+
+/* Generate the arguments of the case c without evaluating it */
+static void QCC_regeneratePlan(QCC_Plan *plan, QCC_Case c, int64_t caseIndex) {
+  QCC_Arena *prevArena = QCC_useArena(plan->arena);
+
+  plan->seed = c.seed;
+  plan->size = c.size;
+  plan->edge = c.edge;
+  plan->caseIndex = caseIndex;
+  plan->enumerated = QCC_FALSE;
+  QCC_clearPlanValues(plan);
+  QCC_resetArena(plan->arena);
+  QCC_generateCase(plan->gens, plan->genNum, c, plan->vals);
+  plan->generated = QCC_TRUE;
+  QCC_useArena(prevArena);
+}
+
+/***********************************************************************
+ *  Failure database
+ ***********************************************************************/
+
+/*
+ * The failure database is an append-only file: an 8 bytes magic followed
+ * by 24 bytes records, each one holding the hash of a property name and
+ * the seed, size and edge prefix index plus one (0 for the cases out of
+ * the prefix) of a case which falsified it, in host byte order. It
+ * is mapped to look up the records of a property, so even large databases
+ * cost little to replay.
+ */
+#define QCC_FAILURES_MAGIC "QCCFDB2"
+#define QCC_FAILURES_HEADER 8
+
+typedef struct QCC_FailureRecord {
+  uint64_t key;
+  uint64_t seed;
+  int32_t size;
+  int32_t edge;
+} QCC_FailureRecord;
+
+static char *QCC_failuresPath = NULL;
+
+void QCC_setFailureDatabase(const char *path) {
+  free(QCC_failuresPath);
+  QCC_failuresPath = path ? strdup(path) : NULL;
+}
+
+/* Cases recorded for the plan, NULL if there are none */
+static QCC_Case* QCC_loadFailures(QCC_Plan *plan, size_t *n) {
+  QCC_Case *cases = NULL;
+  struct stat st;
+  size_t i, recordsN;
+  int fd;
+
+  *n = 0;
+  if (!QCC_failuresPath || !plan->name) return NULL;
+  if ((fd = open(QCC_failuresPath, O_RDONLY)) < 0) return NULL;
+  if (fstat(fd, &st) || st.st_size < QCC_FAILURES_HEADER + (off_t) sizeof(QCC_FailureRecord)) {
+    close(fd);
+    return NULL;
+  }
+
+  char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return NULL;
+
+  if (memcmp(map, QCC_FAILURES_MAGIC, QCC_FAILURES_HEADER) == 0) {
+    QCC_FailureRecord *records = (QCC_FailureRecord *) (map + QCC_FAILURES_HEADER);
+    uint64_t key = QCC_hashLabel(plan->name);
+    recordsN = (st.st_size - QCC_FAILURES_HEADER) / sizeof(QCC_FailureRecord);
+    for (i=0; i<recordsN; i++) {
+      if (records[i].key != key) continue;
+      if ((*n & (*n - 1)) == 0) cases = realloc(cases, sizeof(QCC_Case) * (*n ? 2 * *n : 1));
+      cases[(*n)++] = (QCC_Case) { .seed=records[i].seed, .size=records[i].size, .edge=records[i].edge - 1 };
+    }
+  }
+  munmap(map, st.st_size);
+  return cases;
+}
+
+/* Record the falsifying case of plan, unless already there */
+static void QCC_recordFailure(QCC_Plan *plan) {
+  QCC_FailureRecord record;
+  struct stat st;
+  size_t i, n;
+  int fd;
+
+  QCC_Case *cases = QCC_loadFailures(plan, &n);
+  for (i=0; i<n && (cases[i].seed != plan->seed || cases[i].size != plan->size || cases[i].edge != plan->edge); i++);
+  free(cases);
+  /* Enumerated cases are not identified by their seed */
+  if (!QCC_failuresPath || !plan->name || plan->enumerated || i < n) return;
+
+  if ((fd = open(QCC_failuresPath, O_WRONLY | O_APPEND | O_CREAT, 0644)) < 0) return;
+  if (fstat(fd, &st) == 0 && st.st_size == 0 &&
+      write(fd, QCC_FAILURES_MAGIC, QCC_FAILURES_HEADER) != QCC_FAILURES_HEADER) {
+    close(fd);
+    return;
+  }
+  record = (QCC_FailureRecord) { .key=QCC_hashLabel(plan->name), .seed=plan->seed,
+                                 .size=plan->size, .edge=plan->edge + 1 };
+  if (write(fd, &record, sizeof(record)) != sizeof(record)) perror(QCC_failuresPath);
+  close(fd);
+}
+
+/*
+ * Run the recorded cases of plan. Returns 1, leaving the plan on the case,
+ * if one of them still falsifies the property; replayed cases are not
+ * counted otherwise.
+ */
+static int QCC_replayFailures(QCC_Plan *plan, QCC_Case *cases, size_t n) {
+  size_t i;
+
+  for (i=0; i<n; i++)
+    if (QCC_planStepCase(plan, cases[i]) == QCC_FAIL) return 1;
+
+  plan->status = QCC_OK;
+  plan->succ = plan->fail = 0;
+  plan->discards = (QCC_DiscardStats) { 0, 0, 0, 0 };
+  QCC_resetStamp(plan->stamps);
+  return 0;
+}
+
+/***********************************************************************
+ *  Isolated testing functions
+ ***********************************************************************/
+
+/*
+ * In isolation mode cases run in a pool of worker processes forked when the
+ * run starts and reused for all its cases. Each worker shares a slot with
+ * the runner: the runner writes there a batch of case indices and rings the
+ * worker through a pipe; the worker runs the cases, seeding each one from
+ * (run seed, case index), and publishes after every case the number of
+ * cases done and the labels gathered so far, then rings back. A worker
+ * which dies or stops making progress is thus caught on a known case,
+ * whose arguments the runner rebuilds from its seed.
+ */
+#define QCC_ISOLATED_BATCH 256
+#define QCC_ISOLATED_LABELS 65536
+
+static int QCC_isolatedWorkers = 0;
+static double QCC_isolatedTimeout = 0;
+
+/*
+ * Threads of the property scheduler run their cases in-process: worker
+ * pools forked concurrently by several threads would inherit each other's
+ * pipes and never see them closed.
+ */
+static _Thread_local QCC_Boolean QCC_schedulerThread = QCC_FALSE;
+
+void QCC_setIsolation(int workers, double timeout) {
+  QCC_isolatedWorkers = workers > 0 ? workers : 0;
+  QCC_isolatedTimeout = timeout > 0 ? timeout : 0;
+}
+
+typedef struct QCC_IsolatedSlot {
+  uint64_t runSeed;
+  int first;
+  int count;
+  /* Replayed cases, which are run instead of first..count */
+  int casesN;
+  QCC_Case cases[QCC_ISOLATED_BATCH];
+  int maxFail;
+  int succ;
+  int fail;
+  QCC_DiscardStats discards;
+  QCC_TestStatus status;
+  size_t labelsLen;
+  atomic_int done;
+  /* Labels of the successful cases, NUL terminated, each counting once */
+  char labels[QCC_ISOLATED_LABELS];
+} QCC_IsolatedSlot;
+
+typedef struct QCC_IsolatedWorker {
+  pid_t pid;
+  int toWorker;
+  int fromWorker;
+  QCC_IsolatedSlot *slot;
+  QCC_Boolean busy;
+  int lastDone;
+  double lastProgress;
+} QCC_IsolatedWorker;
+
+static void QCC_appendCaseLabels(QCC_IsolatedSlot *slot, QCC_Stamp *stamps) {
+  int i;
+  if (!stamps) return;
+  for (i=0; i<stamps->touchedN; i++) {
+    QCC_StampEntry *e = &stamps->entries[stamps->touched[i]];
+    size_t len = strlen(e->label) + 1;
+    if (slot->labelsLen + len > QCC_ISOLATED_LABELS) return;
+    memcpy(slot->labels + slot->labelsLen, e->label, len);
+    slot->labelsLen += len;
+  }
+}
+
+static void QCC_mergeSlotLabels(QCC_Plan *plan, QCC_IsolatedSlot *slot) {
+  size_t p = 0;
+
+  if (slot->labelsLen && !plan->stamps) plan->stamps = QCC_newStamp();
+  while (p < slot->labelsLen) {
+    char *label = slot->labels + p;
+    QCC_labelN(plan->stamps, QCC_findLabel(plan->stamps, label, QCC_hashLabel(label)), 1);
+    p += strlen(label) + 1;
+  }
+}
+
+static QCC_Case QCC_slotCase(QCC_IsolatedSlot *slot, int offset) {
+  if (slot->casesN) return slot->cases[offset];
+  return QCC_indexCase(slot->runSeed, slot->first + offset);
+}
+
+static void QCC_isolatedWorker(QCC_Plan *plan, QCC_IsolatedSlot *slot, int in, int out) {
+  char c;
+  int i;
+
+  while (read(in, &c, 1) == 1) {
+    slot->succ = slot->fail = 0;
+    slot->labelsLen = 0;
+    slot->status = QCC_OK;
+    slot->discards = plan->discards = (QCC_DiscardStats) { 0, 0, 0, 0 };
+
+    for (i=0; i<slot->count; i++) {
+      /* Leave room for the labels of the next case */
+      if (slot->labelsLen > QCC_ISOLATED_LABELS / 2) break;
+
+      slot->status = QCC_planStepCase(plan, QCC_slotCase(slot, i));
+
+      if (slot->status == QCC_OK) {
+        slot->succ++;
+        QCC_appendCaseLabels(slot, plan->caseStamps);
+      } else if (slot->status == QCC_NOTHING) {
+        slot->fail++;
+      }
+      slot->discards = plan->discards;
+      atomic_store_explicit(&slot->done, i+1, memory_order_release);
+      if (slot->status == QCC_FAIL || slot->fail >= slot->maxFail) break;
+    }
+
+    fflush(NULL);
+    if (write(out, &c, 1) != 1) break;
+  }
+  _exit(0);
+}
+
+static int QCC_spawnWorker(QCC_Plan *plan, QCC_IsolatedWorker *workers, int idx) {
+  QCC_IsolatedWorker *w = &workers[idx];
+  int toWorker[2], fromWorker[2];
+  int i;
+
+  if (pipe(toWorker)) return -1;
+  if (pipe(fromWorker)) {
+    close(toWorker[0]);
+    close(toWorker[1]);
+    return -1;
+  }
+
+  fflush(NULL);
+  w->pid = fork();
+  if (w->pid == 0) {
+    /* Other workers must see end of file when the runner closes its ends */
+    for (i=0; i<idx; i++) {
+      close(workers[i].toWorker);
+      close(workers[i].fromWorker);
+    }
+    close(toWorker[1]);
+    close(fromWorker[0]);
+    QCC_isolatedWorker(plan, w->slot, toWorker[0], fromWorker[1]);
+  }
+
+  close(toWorker[0]);
+  close(fromWorker[1]);
+  w->toWorker = toWorker[1];
+  w->fromWorker = fromWorker[0];
+  w->busy = QCC_FALSE;
+  if (w->pid < 0) {
+    close(w->toWorker);
+    close(w->fromWorker);
+    return -1;
+  }
+  return 0;
+}
+
+static void QCC_stopWorker(QCC_IsolatedWorker *w, QCC_Boolean force) {
+  if (w->pid > 0 && force) kill(w->pid, SIGKILL);
+  close(w->toWorker);
+  close(w->fromWorker);
+  if (w->pid > 0) waitpid(w->pid, NULL, 0);
+  w->pid = -1;
+}
+
+static void QCC_describeExit(int status, char *buf, size_t size) {
+  if (WIFSIGNALED(status))
+    snprintf(buf, size, "killed by signal %d: %s", WTERMSIG(status), strsignal(WTERMSIG(status)));
+  else
+    snprintf(buf, size, "exited with status %d", WEXITSTATUS(status));
+}
+
+/* Account the cases a worker completed in its current batch */
+static void QCC_collectWorker(QCC_Plan *plan, QCC_IsolatedWorker *w, int *inflight) {
+  *inflight -= w->slot->count;
+  w->busy = QCC_FALSE;
+  if (w->slot->casesN) return;
+  plan->succ += w->slot->succ;
+  plan->fail += w->slot->fail;
+  QCC_addDiscards(&plan->discards, &w->slot->discards);
+  QCC_mergeSlotLabels(plan, w->slot);
+}
+
+/*
+ * Rebuild in the runner the arguments of the offset-th case of the current
+ * batch of a worker, which falsified the property.
+ */
+static void QCC_failWorkerCase(QCC_Plan *plan, QCC_IsolatedWorker *w, int offset) {
+  QCC_regeneratePlan(plan, QCC_slotCase(w->slot, offset), w->slot->casesN ? -1 : w->slot->first + offset);
+  plan->status = QCC_FAIL;
+}
+
+/*
+ * Run the cases of plan in a pool of worker processes until num of them
+ * succeeded, maxFail were discarded or one falsified the property. The n
+ * replayed cases are run first. Returns -1 if the pool could not be
+ * started.
+ */
+static int QCC_runIsolated(QCC_Plan *plan, int num, int maxFail, QCC_Case *cases, size_t n) {
+  int workersN = QCC_isolatedWorkers;
+  QCC_IsolatedWorker *workers = calloc(workersN, sizeof(QCC_IsolatedWorker));
+  struct pollfd *fds = malloc(sizeof(struct pollfd) * workersN);
+  struct sigaction ignore = { .sa_handler=SIG_IGN }, prevPipe;
+  uint64_t runSeed = plan->runSeed;
+  int timeoutMs = QCC_isolatedTimeout > 0 ? (int) (QCC_isolatedTimeout * 250) + 1 : -1;
+  int nextCase = 0, inflight = 0, started = 0;
+  size_t replayed = 0;
+  int i, j, status;
+  char c = 0;
+
+  /* Writing to a dead worker must not kill the runner */
+  sigaction(SIGPIPE, &ignore, &prevPipe);
+  for (started=0; started<workersN; started++) {
+    workers[started].slot = mmap(NULL, sizeof(QCC_IsolatedSlot), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (workers[started].slot == MAP_FAILED) break;
+    if (QCC_spawnWorker(plan, workers, started)) {
+      munmap(workers[started].slot, sizeof(QCC_IsolatedSlot));
+      break;
+    }
+  }
+
+  plan->isolated = started == workersN;
+  while (started == workersN && plan->status != QCC_FAIL) {
+    for (i=0; i<workersN; i++) {
+      QCC_IsolatedWorker *w = &workers[i];
+      int needed = num - plan->succ - inflight;
+      if (w->busy) continue;
+
+      if (replayed < n) {
+        w->slot->casesN = n - replayed < QCC_ISOLATED_BATCH ? n - replayed : QCC_ISOLATED_BATCH;
+        memcpy(w->slot->cases, cases + replayed, sizeof(QCC_Case) * w->slot->casesN);
+        w->slot->count = w->slot->casesN;
+        w->slot->maxFail = INT_MAX;
+        replayed += w->slot->casesN;
+      } else {
+        /* New cases start once all the replayed ones are done */
+        QCC_Boolean replaying = QCC_FALSE;
+        for (j=0; j<workersN; j++) replaying |= workers[j].busy && workers[j].slot->casesN;
+        if (replaying || needed <= 0 || plan->fail >= maxFail) continue;
+
+        w->slot->casesN = 0;
+        w->slot->runSeed = runSeed;
+        w->slot->first = nextCase;
+        w->slot->count = needed < QCC_ISOLATED_BATCH ? needed : QCC_ISOLATED_BATCH;
+        w->slot->maxFail = maxFail - plan->fail;
+        nextCase += w->slot->count;
+      }
+      atomic_store(&w->slot->done, 0);
+      inflight += w->slot->count;
+      w->busy = QCC_TRUE;
+      w->lastDone = 0;
+      w->lastProgress = QCC_now();
+      /* A failed write means the worker died, which poll reports */
+      if (write(w->toWorker, &c, 1) != 1) continue;
+    }
+
+    int busyN = 0;
+    for (i=0; i<workersN; i++) {
+      if (!workers[i].busy) continue;
+      fds[busyN++] = (struct pollfd) { .fd=workers[i].fromWorker, .events=POLLIN, .revents=0 };
+    }
+    if (busyN == 0) break;
+    if (poll(fds, busyN, timeoutMs) < 0) continue;
+
+    for (i=0, j=0; i<workersN && plan->status != QCC_FAIL; i++) {
+      QCC_IsolatedWorker *w = &workers[i];
+      if (!w->busy) continue;
+      struct pollfd *fd = &fds[j++];
+
+      if (fd->revents) {
+        if (read(w->fromWorker, &c, 1) == 1) {
+          QCC_collectWorker(plan, w, &inflight);
+          if (w->slot->status == QCC_FAIL)
+            QCC_failWorkerCase(plan, w, atomic_load(&w->slot->done) - 1);
+        } else {
+          waitpid(w->pid, &status, 0);
+          w->pid = -1;
+          QCC_describeExit(status, plan->crash, sizeof(plan->crash));
+          QCC_collectWorker(plan, w, &inflight);
+          QCC_failWorkerCase(plan, w, atomic_load(&w->slot->done));
+        }
+      } else if (timeoutMs > 0) {
+        int done = atomic_load_explicit(&w->slot->done, memory_order_acquire);
+        double now = QCC_now();
+        if (done != w->lastDone) {
+          w->lastDone = done;
+          w->lastProgress = now;
+        } else if (now - w->lastProgress >= QCC_isolatedTimeout) {
+          kill(w->pid, SIGKILL);
+          waitpid(w->pid, &status, 0);
+          w->pid = -1;
+          snprintf(plan->crash, sizeof(plan->crash), "timed out after %.3fs", now - w->lastProgress);
+          QCC_collectWorker(plan, w, &inflight);
+          QCC_failWorkerCase(plan, w, done);
+        }
+      }
+    }
+  }
+
+  for (i=0; i<started; i++) {
+    QCC_stopWorker(&workers[i], workers[i].busy);
+    munmap(workers[i].slot, sizeof(QCC_IsolatedSlot));
+  }
+  sigaction(SIGPIPE, &prevPipe, NULL);
+  free(workers);
+  free(fds);
+  return started == workersN ? 0 : -1;
+}
+
+/* Shrink and print the falsifying arguments of failed */
+static void QCC_reportFailure(QCC_Plan *failed, int succ) {
+  QCC_Result res = { .status=QCC_FAIL, .stamps=NULL, .arguments=failed->vals, .argumentsN=failed->genNum };
+  QCC_PROFILE_START(t);
+  QCC_ShrinkStats stats = QCC_shrinkResult(failed->prop, &res);
+  QCC_PROFILE_LAP(failed->profile[QCC_PHASE_SHRINK], t);
+  QCC_reportf("Falsifiable after %d test\n", succ+1);
+  QCC_printArguments(res.arguments, res.argumentsN);
+  QCC_PROFILE_LAP(failed->profile[QCC_PHASE_SHOW], t);
+  if (stats.steps)
+    QCC_reportf("Shrunk %d times in %d steps (%.3fs%s)\n", stats.shrinks, stats.steps, stats.seconds,
+           stats.exhausted ? ", budget exhausted" : "");
+}
+
+/*
+ * In isolation mode shrink candidates run in a forked process too: if one
+ * of them crashes, the unshrunk arguments are printed instead.
+ */
+static void QCC_reportIsolatedFailure(QCC_Plan *failed, int succ) {
+  char crash[96];
+  int status;
+  pid_t pid;
+
+  fflush(NULL);
+  pid = fork();
+  if (pid == 0) {
+    QCC_reportFailure(failed, succ);
+    fflush(NULL);
+    _exit(0);
+  }
+
+  if (pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0) return;
+  if (pid > 0) QCC_describeExit(status, crash, sizeof(crash));
+  else snprintf(crash, sizeof(crash), "not shrunk");
+  QCC_reportf("Falsifiable after %d test (shrinking %s)\n", succ+1, crash);
+  QCC_printArguments(failed->vals, failed->genNum);
+}
+
+/* Print which share of the generation work was thrown away */
+static void QCC_reportDiscards(int succ, int fail, QCC_DiscardStats *discards) {
+  /* Duplicates are not counted as cases */
+  fail -= discards->duplicates;
+  if (discards->duplicates)
+    QCC_reportf("Skipped %d duplicate cases, %d unique cases tested\n", discards->duplicates, succ + fail);
+  if (fail)
+    QCC_reportf("Discarded %d of %d cases (%.1f%%): %d by generators, %d by the property\n",
+                fail, succ + fail, 100.0 * fail / (succ + fail),
+                discards->generators, fail - discards->generators);
+  if (discards->filterRejects)
+    QCC_reportf("Filters rejected %llu of %llu values (%.1f%%)\n",
+                (unsigned long long) discards->filterRejects, (unsigned long long) discards->filterTries,
+                100.0 * discards->filterRejects / discards->filterTries);
+}
+
+/*
+ * Report the outcome of a run. failed is the plan holding the falsifying
+ * arguments (NULL if none was found): they are shrunk and printed out of
+ * its arena.
+ */
+static int QCC_report(int num, int maxFail, int succ, int fail, QCC_DiscardStats *discards,
+                      QCC_Plan *failed, QCC_Stamp *stamps) {
+  if (succ == num) {
+    QCC_reportf("%d test passed (%d)!\n", succ, fail);
+    QCC_reportDiscards(succ, fail, discards);
+    QCC_printStamps(stamps, succ);
+    return 0;
+  } else if (failed) {
+    QCC_Arena *prevArena = QCC_useArena(failed->arena);
+    QCC_recordFailure(failed);
+    if (failed->crash[0]) {
+      /* Evaluating the arguments again would take the runner down */
+      QCC_reportf("Falsifiable after %d test (%s)\n", succ+1, failed->crash);
+      QCC_printArguments(failed->vals, failed->genNum);
+    } else if (failed->isolated) {
+      QCC_reportIsolatedFailure(failed, succ);
+    } else {
+      QCC_reportFailure(failed, succ);
+    }
+    if (failed->enumerated)
+      QCC_reportf("Case %lld of the enumeration of the domain\n", (long long) failed->caseIndex);
+    else if (failed->lane >= 0)
+      QCC_reportf("Run seed 0x%016llx, batch %lld, lane %d (see QCC_replayBatch)\n",
+             (unsigned long long) failed->runSeed, (long long) failed->caseIndex, failed->lane);
+    else if (failed->caseIndex >= 0)
+      QCC_reportf("Run seed 0x%016llx, case %lld, size %d (see QCC_replay)\n",
+             (unsigned long long) failed->runSeed, (long long) failed->caseIndex, failed->size);
+    else
+      QCC_reportf("Case seed 0x%016llx, size %d (replayed from the failure database)\n",
+             (unsigned long long) failed->seed, failed->size);
+    QCC_useArena(prevArena);
+    return 1;
+  } else if (fail >= maxFail) {
+    QCC_reportf("Gave up after %d tests!\n", succ);
+    QCC_reportDiscards(succ, fail, discards);
+    QCC_printStamps(stamps, succ);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * Generate the tuple of e whose first choices were fixed by the runner,
+ * at the maximum size. Random draws all come from the run seed, so that a
+ * tuple only depends on its choices. Returns whether the generators asked
+ * for the random generator, i.e. whether some values were drawn rather
+ * than enumerated.
+ */
+static QCC_Boolean QCC_generateTuple(QCC_Plan *plan, QCC_Enumeration *e, int64_t caseIndex) {
+  QCC_Enumeration *prevEnum = QCC_currentEnum;
+
+  e->n = 0;
+  QCC_currentEnum = e;
+  QCC_rngUsed = QCC_FALSE;
+  QCC_regeneratePlan(plan, (QCC_Case) { .seed=plan->runSeed, .size=QCC_maxSize, .edge=-1 }, caseIndex);
+  QCC_currentEnum = prevEnum;
+  plan->enumerated = QCC_TRUE;
+  return QCC_rngUsed;
+}
+
+/*
+ * Run the current tuple of e, unless all its choices are below skipBelow
+ * (it was run at a lower depth already). Returns whether the generators
+ * drew random values.
+ */
+static QCC_Boolean QCC_planStepTuple(QCC_Plan *plan, QCC_Enumeration *e, uint64_t skipBelow) {
+  uint64_t filterTries = QCC_filterTries, filterRejects = QCC_filterRejects;
+  QCC_Boolean random = QCC_generateTuple(plan, e, (int64_t) plan->cases);
+  QCC_Arena *prevArena;
+  uint64_t top = 0;
+  int i;
+
+  for (i=0; i<e->n; i++) if (e->choices[i] > top) top = e->choices[i];
+  if (skipBelow && top < skipBelow) return random;
+
+  plan->cases++;
+  plan->discards.filterTries += QCC_filterTries - filterTries;
+  plan->discards.filterRejects += QCC_filterRejects - filterRejects;
+  for (i=0; i<plan->genNum && plan->vals[i]; i++);
+  if (i < plan->genNum) {
+    plan->status = QCC_NOTHING;
+    plan->fail++;
+    plan->discards.generators++;
+  } else {
+    prevArena = QCC_useArena(plan->arena);
+    QCC_planEvaluate(plan);
+    QCC_useArena(prevArena);
+  }
+  return random;
+}
+
+/*
+ * Move e to the next tuple, in lexicographic order of the choices: the
+ * last choice which can grow is incremented and the following ones are
+ * reset. Returns 0 after the last tuple.
+ */
+static int QCC_nextTuple(QCC_Enumeration *e) {
+  int i;
+
+  for (i=e->n-1; i>=0; i--) {
+    if (e->choices[i] + 1 < e->sizes[i] && e->choices[i] < e->bound) {
+      e->choices[i]++;
+      e->fixed = i + 1;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Run the tuples of the domain of plan with every choice up to depth (no
+ * bound if negative), until num of them passed, maxFail were discarded or
+ * the property is falsified. The diagonal order raises the bound one
+ * level at a time, each level running the tuples with a choice equal to
+ * it. Returns whether the whole domain was run.
+ */
+static QCC_Boolean QCC_enumeratePlan(QCC_Plan *plan, int depth, QCC_EnumOrder order, int num, int maxFail) {
+  QCC_Enumeration e = { .choices=NULL, .sizes=NULL, .n=0, .fixed=0, .cap=0 };
+  uint64_t bound = depth < 0 ? UINT64_MAX : (uint64_t) depth;
+  uint64_t level = order == QCC_DIAGONAL ? 0 : bound;
+  QCC_Boolean random = QCC_FALSE;
+  int more;
+
+  for (;;) {
+    e.bound = level;
+    e.fixed = 0;
+    e.truncated = QCC_FALSE;
+    do {
+      random |= QCC_planStepTuple(plan, &e, order == QCC_DIAGONAL ? level : 0);
+      more = QCC_nextTuple(&e);
+    } while (more && plan->status != QCC_FAIL && plan->succ < num && plan->fail < maxFail);
+    if (more || !e.truncated || level >= bound ||
+        plan->status == QCC_FAIL || plan->succ >= num || plan->fail >= maxFail) break;
+    level++;
+  }
+
+  free(e.choices);
+  free(e.sizes);
+  return !more && !e.truncated && !random;
+}
+
+/*
+ * Number of tuples of the domain of plan if at most max, 0 if larger or
+ * if its generators draw random values. Only the choices of the first
+ * tuple are looked at: the domain is larger if later choices depend on
+ * earlier ones, which enumerations stop at max passed tuples anyway.
+ */
+static uint64_t QCC_planDomain(QCC_Plan *plan, int max) {
+  QCC_Enumeration e = { .choices=NULL, .sizes=NULL, .n=0, .fixed=0, .cap=0, .bound=UINT64_MAX };
+  uint64_t tuples = 1;
+  int i;
+
+  if (!QCC_autoEnumerate || max <= 0) return 0;
+  if (QCC_generateTuple(plan, &e, 0)) tuples = 0;
+  for (i=0; i<e.n && tuples; i++) tuples = e.sizes[i] > (uint64_t) max / tuples ? 0 : tuples * e.sizes[i];
+  free(e.choices);
+  free(e.sizes);
+  return tuples;
+}
+
+/*
+ * Report an enumeration as QCC_report does, telling on success whether
+ * the domain was exhausted, i.e. the property proved over it.
+ */
+static int QCC_reportEnumerated(QCC_Plan *plan, int maxFail, QCC_Boolean exhausted, int depth) {
+  if (plan->status == QCC_FAIL || plan->fail >= maxFail)
+    return QCC_report(-1, maxFail, plan->succ, plan->fail, &plan->discards,
+                      plan->status == QCC_FAIL ? plan : NULL, plan->stamps);
+
+  if (exhausted) QCC_reportf("%d test passed (%d), domain exhausted!\n", plan->succ, plan->fail);
+  else if (depth >= 0) QCC_reportf("%d test passed (%d) up to depth %d!\n", plan->succ, plan->fail, depth);
+  else QCC_reportf("%d test passed (%d)!\n", plan->succ, plan->fail);
+  QCC_reportDiscards(plan->succ, plan->fail, &plan->discards);
+  QCC_printStamps(plan->stamps, plan->succ);
+  return 0;
+}
+
+int QCC_planRun(QCC_Plan *plan, int num, int maxFail) {
+  QCC_Boolean exhausted = QCC_FALSE;
+  size_t replayN;
+  QCC_Case *replay;
+
+  QCC_resetPlan(plan);
+  replay = QCC_loadFailures(plan, &replayN);
+  if (!QCC_isolatedWorkers || QCC_schedulerThread ||
+      QCC_runIsolated(plan, num, maxFail, replay, replayN)) {
+    if (!QCC_replayFailures(plan, replay, replayN)) {
+      /* Domains no larger than num are enumerated rather than sampled */
+      if (QCC_planDomain(plan, num)) exhausted = QCC_enumeratePlan(plan, -1, QCC_LEXICOGRAPHIC, num, maxFail);
+      while (!exhausted && plan->status != QCC_FAIL && plan->succ < num && plan->fail < maxFail)
+        QCC_planStep(plan);
+    }
+  }
+  free(replay);
+
+  if (exhausted) return QCC_reportEnumerated(plan, maxFail, QCC_TRUE, -1);
+  return QCC_report(num, maxFail, plan->succ, plan->fail, &plan->discards,
+                    plan->status == QCC_FAIL ? plan : NULL, plan->stamps);
+}
+
+int QCC_testForAll(int num, int maxFail, QCC_property prop, int genNum, ...) {
+  va_list genP;
   va_start(genP, genNum);
-  res = QCC_vforAll(prop, genNum, genP);
+  QCC_Plan *plan = QCC_vnewPlan(prop, genNum, genP);
   va_end(genP);
-  return res;
+
+  int ret = QCC_planRun(plan, num, maxFail);
+  QCC_freePlan(plan);
+  return ret;
+}
+
+int QCC_testForAllNamed(const char *name, int num, int maxFail, QCC_property prop, int genNum, ...) {
+  va_list genP;
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(prop, genNum, genP);
+  va_end(genP);
+
+  QCC_setPlanName(plan, name);
+  int ret = QCC_planRun(plan, num, maxFail);
+  QCC_freePlan(plan);
+  return ret;
+}
+
+int QCC_planReplay(QCC_Plan *plan, uint64_t runSeed, uint64_t caseIndex) {
+  QCC_resetPlan(plan);
+  plan->runSeed = runSeed;
+  plan->cases = caseIndex;
+  QCC_planStep(plan);
+
+  return QCC_report(1, 1, plan->succ, plan->fail, &plan->discards,
+                    plan->status == QCC_FAIL ? plan : NULL, plan->stamps);
+}
+
+int QCC_replay(uint64_t runSeed, uint64_t caseIndex, QCC_property prop, int genNum, ...) {
+  va_list genP;
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(prop, genNum, genP);
+  va_end(genP);
+
+  int ret = QCC_planReplay(plan, runSeed, caseIndex);
+  QCC_freePlan(plan);
+  return ret;
+}
+
+int QCC_planEnumerate(QCC_Plan *plan, int depth, QCC_EnumOrder order, int maxFail) {
+  QCC_Boolean exhausted;
+
+  QCC_resetPlan(plan);
+  exhausted = QCC_enumeratePlan(plan, depth, order, INT_MAX, maxFail);
+  return QCC_reportEnumerated(plan, maxFail, exhausted, depth);
+}
+
+int QCC_testEnumerate(int depth, QCC_EnumOrder order, int maxFail, QCC_property prop, int genNum, ...) {
+  va_list genP;
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(prop, genNum, genP);
+  va_end(genP);
+
+  int ret = QCC_planEnumerate(plan, depth, order, maxFail);
+  QCC_freePlan(plan);
+  return ret;
+}
+
+/*
+ * Step plan until the deadline, falsification or maxFail discarded cases.
+ * The clock is read every stride cases, doubling the stride while cases
+ * are too fast for reading it each time to be negligible.
+ */
+static void QCC_planStepUntil(QCC_Plan *plan, double deadline, int maxFail) {
+  double last = QCC_now();
+  int stride = 1;
+  int i;
+
+  while (plan->fail < maxFail) {
+    for (i=0; i<stride && plan->fail < maxFail; i++)
+      if (QCC_planStep(plan) == QCC_FAIL) return;
+
+    double now = QCC_now();
+    if (now >= deadline) return;
+    if (now - last < 1e-4 && stride < 1024) stride *= 2;
+    last = now;
+  }
+}
+
+static int QCC_reportTimed(QCC_Plan *plan, int maxFail, double seconds) {
+  QCC_Boolean failed = plan->status == QCC_FAIL;
+  int cases = plan->succ + plan->fail + failed;
+  /* A run which was neither falsified nor gave up passed all its cases */
+  int num = failed || plan->fail >= maxFail ? -1 : plan->succ;
+  int ret = QCC_report(num, maxFail, plan->succ, plan->fail, &plan->discards, failed ? plan : NULL, plan->stamps);
+
+  QCC_reportf("Ran %d cases in %.3fs (%.0f cases/s)\n", cases, seconds, seconds > 0 ? cases / seconds : 0);
+  return ret;
+}
+
+int QCC_planRunFor(QCC_Plan *plan, double seconds, int maxFail) {
+  double start = QCC_now();
+  size_t replayN;
+  QCC_Case *replay;
+
+  QCC_resetPlan(plan);
+  replay = QCC_loadFailures(plan, &replayN);
+  if (!QCC_replayFailures(plan, replay, replayN))
+    QCC_planStepUntil(plan, start + seconds, maxFail);
+  free(replay);
+  return QCC_reportTimed(plan, maxFail, QCC_now() - start);
+}
+
+int QCC_testFor(double seconds, int maxFail, QCC_property prop, int genNum, ...) {
+  va_list genP;
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(prop, genNum, genP);
+  va_end(genP);
+
+  int ret = QCC_planRunFor(plan, seconds, maxFail);
+  QCC_freePlan(plan);
+  return ret;
+}
+
+/*
+ * A share of the budget is spent probing the cost of a case of each plan;
+ * the rest is split in proportion to those costs, so that slow properties
+ * are not starved of cases by fast ones.
+ */
+#define QCC_PROBE_SHARE 0.05
+
+int QCC_planRunAllFor(QCC_Plan **plans, int plansN, double seconds, int maxFail) {
+  double *cost = malloc(sizeof(double) * (plansN ? plansN : 1));
+  double *elapsed = malloc(sizeof(double) * (plansN ? plansN : 1));
+  double totalCost = 0, start = QCC_now(), now;
+  int ret = 0, cases, r, i;
+  size_t replayN;
+  QCC_Case *replay;
+
+  for (i=0; i<plansN; i++) {
+    now = QCC_now();
+    QCC_resetPlan(plans[i]);
+    replay = QCC_loadFailures(plans[i], &replayN);
+    if (!QCC_replayFailures(plans[i], replay, replayN))
+      QCC_planStepUntil(plans[i], now + seconds * QCC_PROBE_SHARE / plansN, maxFail);
+    free(replay);
+    elapsed[i] = QCC_now() - now;
+    cases = plans[i]->succ + plans[i]->fail + (plans[i]->status == QCC_FAIL);
+    cost[i] = elapsed[i] / (cases ? cases : 1);
+    if (plans[i]->status != QCC_FAIL && plans[i]->fail < maxFail) totalCost += cost[i];
+  }
+
+  double remaining = seconds - (QCC_now() - start);
+  for (i=0; i<plansN; i++) {
+    if (plans[i]->status != QCC_FAIL && plans[i]->fail < maxFail && remaining > 0) {
+      now = QCC_now();
+      QCC_planStepUntil(plans[i], now + remaining * cost[i] / totalCost, maxFail);
+      elapsed[i] += QCC_now() - now;
+    }
+
+    QCC_reportf("Property %d of %d\n", i+1, plansN);
+    r = QCC_reportTimed(plans[i], maxFail, elapsed[i]);
+    if (r == 1 || (r == -1 && ret == 0)) ret = r;
+  }
+
+  free(cost);
+  free(elapsed);
+  return ret;
+}
+
+/***********************************************************************
+ *  Batch testing functions
+ ***********************************************************************/
+static void QCC_fillBooleanColumn(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  QCC_rngFillBoolean(rng, buf, n);
+}
+
+static void QCC_fillCharColumn(QCC_Rng *rng, void *buf, int n, const void *from, const void *to) {
+  QCC_rngFillChar(rng, buf, n);
+}
+
+static QCC_Column QCC_columnLongRI(long first, long last) {
+  return (QCC_Column) { .elemSize=sizeof(long), .fill=QCC_fillLongR, .show=QCC_showLong,
+                        .write=QCC_writeLong, .shrink=QCC_shrinkLong, .bounded=QCC_TRUE,
+                        .from.l=first, .to.l=last };
+}
+
+QCC_Column QCC_columnLongR(long from, long to) {
+  return QCC_columnLongRI(from, to > from ? to - 1 : from);
+}
+
+QCC_Column QCC_columnLong() {
+  return QCC_columnLongRI(QCC_LONG_FROM, QCC_LONG_TO);
+}
+
+static QCC_Column QCC_columnIntRI(int first, int last) {
+  return (QCC_Column) { .elemSize=sizeof(int), .fill=QCC_fillIntR, .show=QCC_showInt,
+                        .write=QCC_writeInt, .shrink=QCC_shrinkInt, .bounded=QCC_TRUE,
+                        .from.i=first, .to.i=last };
+}
+
+QCC_Column QCC_columnIntR(int from, int to) {
+  return QCC_columnIntRI(from, to > from ? to - 1 : from);
+}
+
+QCC_Column QCC_columnInt() {
+  return QCC_columnIntRI(QCC_INT_FROM, QCC_INT_TO);
+}
+
+QCC_Column QCC_columnDoubleR(double from, double to) {
+  return (QCC_Column) { .elemSize=sizeof(double), .fill=QCC_fillDoubleR, .show=QCC_showDouble,
+                        .write=QCC_writeDouble, .shrink=QCC_shrinkDouble, .bounded=QCC_TRUE,
+                        .from.d=from, .to.d=to };
+}
+
+QCC_Column QCC_columnDouble() {
+  return QCC_columnDoubleR(QCC_DOUBLE_FROM, QCC_DOUBLE_TO);
+}
+
+QCC_Column QCC_columnFloatR(float from, float to) {
+  return (QCC_Column) { .elemSize=sizeof(float), .fill=QCC_fillFloatR, .show=QCC_showFloat,
+                        .write=QCC_writeFloat, .shrink=QCC_shrinkFloat, .bounded=QCC_TRUE,
+                        .from.f=from, .to.f=to };
+}
+
+QCC_Column QCC_columnFloat() {
+  return QCC_columnFloatR(QCC_FLOAT_FROM, QCC_FLOAT_TO);
+}
+
+QCC_Column QCC_columnBoolean() {
+  return (QCC_Column) { .elemSize=sizeof(QCC_Boolean), .fill=QCC_fillBooleanColumn, .show=QCC_showBoolean,
+                        .write=QCC_writeBoolean, .shrink=QCC_shrinkBoolean, .bounded=QCC_FALSE };
+}
+
+QCC_Column QCC_columnChar() {
+  return (QCC_Column) { .elemSize=sizeof(char), .fill=QCC_fillCharColumn, .show=QCC_showChar,
+                        .write=QCC_writeChar, .shrink=QCC_shrinkChar, .bounded=QCC_FALSE };
+}
+
+/*
+ * A batch runs on a plan of the single-case property without generators:
+ * the plan arguments are only built for the lanes evaluated on their own.
+ */
+typedef struct QCC_Batch {
+  QCC_Plan *plan;
+  QCC_Column *cols;
+  void **columns;
+} QCC_Batch;
+
+static void QCC_initBatch(QCC_Batch *batch, QCC_property prop, int colNum, va_list colP) {
+  int i;
+
+  batch->plan = QCC_allocPlan(prop, colNum);
+  batch->cols = malloc(sizeof(QCC_Column) * (colNum ? colNum : 1));
+  batch->columns = malloc(sizeof(void *) * (colNum ? colNum : 1));
+  for (i=0; i<colNum; i++) {
+    batch->plan->gens[i] = NULL;
+    batch->cols[i] = va_arg(colP, QCC_Column);
+    batch->columns[i] = malloc(batch->cols[i].elemSize * QCC_BATCH_LANES);
+  }
+}
+
+static void QCC_freeBatch(QCC_Batch *batch) {
+  int i;
+  for (i=0; i<batch->plan->genNum; i++) free(batch->columns[i]);
+  free(batch->columns);
+  free(batch->cols);
+  QCC_freePlan(batch->plan);
+}
+
+/*
+ * Columns are always filled with QCC_BATCH_LANES values, drawn from a seed
+ * derived from the run seed and the batch index, so that any lane can be
+ * rebuilt whatever the number of lanes evaluated.
+ */
+static void QCC_fillBatch(QCC_Batch *batch, uint64_t batchIndex) {
+  QCC_Plan *plan = batch->plan;
+  QCC_Rng rng;
+  int i;
+
+  plan->caseIndex = batchIndex;
+  QCC_rngSeed(&rng, QCC_caseSeed(plan->runSeed, batchIndex));
+  for (i=0; i<plan->genNum; i++)
+    batch->cols[i].fill(&rng, batch->columns[i], QCC_BATCH_LANES, &batch->cols[i].from, &batch->cols[i].to);
+}
+
+static QCC_GenValue* QCC_columnValue(QCC_Column *col, void *elem) {
+  uint8_t *v = QCC_alloc(col->elemSize * (col->bounded ? 3 : 1));
+
+  memcpy(v, elem, col->elemSize);
+  if (col->bounded) {
+    memcpy(v + col->elemSize, &col->from, col->elemSize);
+    memcpy(v + 2*col->elemSize, &col->to, col->elemSize);
+  }
+  return QCC_initShrinkableValue(v, 1, col->show, col->write, QCC_freeAlloc, col->shrink, NULL, QCC_elemsHash(col->elemSize));
+}
+
+/* Evaluate a lane of the batch with the single-case property */
+static QCC_TestStatus QCC_batchLane(QCC_Batch *batch, int lane) {
+  QCC_Plan *plan = batch->plan;
+  QCC_Arena *prevArena = QCC_useArena(plan->arena);
+  int i;
+
+  plan->lane = lane;
+  QCC_clearPlanValues(plan);
+  QCC_resetArena(plan->arena);
+  for (i=0; i<plan->genNum; i++)
+    plan->vals[i] = QCC_columnValue(&batch->cols[i], (uint8_t *) batch->columns[i] + lane * batch->cols[i].elemSize);
+  plan->generated = QCC_TRUE;
+  QCC_planEvaluate(plan);
+  QCC_useArena(prevArena);
+  return plan->status;
+}
+
+/*
+ * Lanes passed by the batch property are only counted; the others are
+ * evaluated again on their own. Returns the number of lanes the two
+ * properties disagree on.
+ */
+static int QCC_runBatches(QCC_Batch *batch, QCC_batchProperty batchProp, int num, int maxFail) {
+  QCC_Plan *plan = batch->plan;
+  int disagreements = 0;
+  uint64_t failing;
+  int n, lane;
+
+  while (plan->succ < num && plan->fail < maxFail && plan->status != QCC_FAIL) {
+    n = num - plan->succ < QCC_BATCH_LANES ? num - plan->succ : QCC_BATCH_LANES;
+    QCC_PROFILE_START(t);
+    QCC_fillBatch(batch, plan->cases++);
+    QCC_PROFILE_LAP(plan->profile[QCC_PHASE_GENERATE], t);
+    failing = batchProp(batch->columns, n);
+    QCC_PROFILE_LAP(plan->profile[QCC_PHASE_EVALUATE], t);
+    if (n < 64) failing &= (1ULL << n) - 1;
+
+    if (!failing) {
+      plan->succ += n;
+      continue;
+    }
+    for (lane=0; lane<n && plan->fail < maxFail; lane++) {
+      if (!((failing >> lane) & 1)) {
+        plan->succ++;
+        continue;
+      }
+      QCC_TestStatus status = QCC_batchLane(batch, lane);
+      if (status == QCC_FAIL) break;
+      if (status == QCC_OK) disagreements++;
+    }
+  }
+
+  return disagreements;
+}
+
+int QCC_testForAllBatch(int num, int maxFail, QCC_batchProperty batchProp, QCC_property prop, int colNum, ...) {
+  QCC_Batch batch;
+  va_list colP;
+  int disagreements, ret;
+
+  va_start(colP, colNum);
+  QCC_initBatch(&batch, prop, colNum, colP);
+  va_end(colP);
+
+  disagreements = QCC_runBatches(&batch, batchProp, num, maxFail);
+  ret = QCC_report(num, maxFail, batch.plan->succ, batch.plan->fail, &batch.plan->discards,
+                   batch.plan->status == QCC_FAIL ? batch.plan : NULL, batch.plan->stamps);
+  if (disagreements)
+    QCC_reportf("Batch property failed %d cases passed by the single-case property\n", disagreements);
+  QCC_freeBatch(&batch);
+  return ret;
+}
+
+int QCC_replayBatch(uint64_t runSeed, uint64_t batchIndex, int lane, QCC_property prop, int colNum, ...) {
+  QCC_Batch batch;
+  va_list colP;
+  int ret = -1;
+
+  va_start(colP, colNum);
+  QCC_initBatch(&batch, prop, colNum, colP);
+  va_end(colP);
+
+  if (lane >= 0 && lane < QCC_BATCH_LANES) {
+    batch.plan->runSeed = runSeed;
+    QCC_fillBatch(&batch, batchIndex);
+    QCC_batchLane(&batch, lane);
+    ret = QCC_report(1, 1, batch.plan->succ, batch.plan->fail, &batch.plan->discards,
+                     batch.plan->status == QCC_FAIL ? batch.plan : NULL, batch.plan->stamps);
+  }
+  QCC_freeBatch(&batch);
+  return ret;
+}
+
+
+/***********************************************************************
+ *  Parallel testing functions
+ ***********************************************************************/
+typedef struct QCC_Worker {
+  pthread_t thread;
+  int num;
+  QCC_Plan *plan;
+  struct QCC_ParallelRun *run;
+} QCC_Worker;
+
+typedef struct QCC_ParallelRun {
+  int maxFail;
+  atomic_int fail;
+  atomic_int stop;
+} QCC_ParallelRun;
+
+static void* QCC_parallelWorker(void *arg) {
+  QCC_Worker *w = arg;
+  QCC_ParallelRun *run = w->run;
+
+  while (w->plan->succ < w->num &&
+         !atomic_load_explicit(&run->stop, memory_order_relaxed) &&
+         atomic_load_explicit(&run->fail, memory_order_relaxed) < run->maxFail) {
+    QCC_TestStatus status = QCC_planStep(w->plan);
+
+    if (status == QCC_FAIL) {
+      atomic_store(&run->stop, 1);
+      break;
+    } else if (status == QCC_NOTHING) {
+      atomic_fetch_add(&run->fail, 1);
+    }
+  }
+  return NULL;
+}
+
+int QCC_testForAllParallel(int threads, int num, int maxFail, QCC_property prop, int genNum, ...) {
+  va_list genP;
+  int i;
+
+  if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads > num) threads = num;
+  if (threads <= 1) threads = 1;
+
+  QCC_ParallelRun run = { .maxFail=maxFail };
+  atomic_init(&run.fail, 0);
+  atomic_init(&run.stop, 0);
+
+  /* Worker plans draw their run seeds from the calling thread's stream so
+   * that a run seeded through QCC_init is reproducible for a given thread
+   * count. */
+  QCC_Worker *workers = calloc(threads, sizeof(QCC_Worker));
+  for (i=0; i<threads; i++) {
+    va_start(genP, genNum);
+    workers[i].plan = QCC_vnewPlan(prop, genNum, genP);
+    va_end(genP);
+    workers[i].num = num/threads + (i < num%threads);
+    workers[i].run = &run;
+  }
+  for (i=0; i<threads; i++)
+    pthread_create(&workers[i].thread, NULL, QCC_parallelWorker, &workers[i]);
+  for (i=0; i<threads; i++) pthread_join(workers[i].thread, NULL);
+
+  int succ = 0;
+  QCC_DiscardStats discards = { 0, 0, 0, 0 };
+  QCC_Plan *failed = NULL;
+  QCC_Stamp *stamps = NULL;
+  for (i=0; i<threads; i++) {
+    succ += workers[i].plan->succ;
+    QCC_addDiscards(&discards, &workers[i].plan->discards);
+    QCC_mergeLabels(&stamps, workers[i].plan->stamps, QCC_FALSE);
+    if (!failed && workers[i].plan->status == QCC_FAIL) failed = workers[i].plan;
+  }
+
+  int ret = QCC_report(num, maxFail, succ, atomic_load(&run.fail), &discards, failed, stamps);
+
+  QCC_freeStamp(stamps);
+  for (i=0; i<threads; i++) QCC_freePlan(workers[i].plan);
+  free(workers);
+  return ret;
+}
+
+/***********************************************************************
+ *  Stateful testing functions
+ ***********************************************************************/
+#define QCC_STATE_MAX_STEPS 100
+#define QCC_STATE_MAX_PREFIX 16
+#define QCC_STATE_MAX_BRANCH 8
+/* Parallel steps are tracked in 64 bits sets */
+#define QCC_STATE_MAX_PARALLEL 32
+#define QCC_STATE_RUNS 8
+
+/*
+ * A program is an array of steps in generation order: the sequential
+ * prefix (thread 0), then the branch of thread 1, 2, ... Arguments are
+ * shared with the shrink candidates of the program. Steps keep the result
+ * of their last run and, in branches, the ticks of the clock of the pool
+ * they were invoked and returned at. The shrink cursor works as the one of
+ * derived values.
+ */
+typedef struct QCC_Step {
+  int command;
+  int thread;
+  QCC_SharedValue *arg;
+  long result;
+  uint64_t invoked;
+  uint64_t returned;
+  QCC_Boolean ran;
+} QCC_Step;
+
+typedef struct QCC_Program {
+  const QCC_StateMachine *sm;
+  int threads;
+  int n;
+  QCC_Step *steps;
+  int lastIdx;
+  int step;
+  int stepIdx;
+} QCC_Program;
+
+/*
+ * Threads running the branches of the parallel programs of the thread
+ * which started them, in lockstep with it through the start and done
+ * barriers.
+ */
+typedef struct QCC_StateWorker {
+  pthread_t thread;
+  int branch;
+  struct QCC_StatePool *pool;
+} QCC_StateWorker;
+
+typedef struct QCC_StatePool {
+  QCC_StateWorker *workers;
+  int n;
+  pid_t pid;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+  QCC_Program *program;
+  void *sut;
+  atomic_ullong clock;
+  QCC_Boolean stop;
+} QCC_StatePool;
+
+/*
+ * History of the branches of a parallel run, with one model per step
+ * linearized so far and the states already explored.
+ */
+typedef struct QCC_History {
+  const QCC_StateMachine *sm;
+  QCC_Step *ops[QCC_STATE_MAX_PARALLEL];
+  int n;
+  uint8_t *models;
+  QCC_CaseSet explored;
+} QCC_History;
+
+static _Thread_local const QCC_StateMachine *QCC_currentMachine = NULL;
+static _Thread_local int QCC_currentThreads = 0;
+static _Thread_local QCC_StatePool *QCC_statePool = NULL;
+
+static QCC_GenValue* QCC_shrinkProgram(QCC_GenValue *gv, int idx);
+
+static inline QCC_GenValue* QCC_stepArg(QCC_Step *s) {
+  return s->arg ? s->arg->value : NULL;
+}
+
+static void QCC_initModel(const QCC_StateMachine *sm, void *model) {
+  memset(model, 0, sm->modelSize);
+  if (sm->initModel) sm->initModel(model);
+}
+
+static QCC_Program* QCC_newProgram(const QCC_StateMachine *sm, int threads, int n) {
+  QCC_Program *p = QCC_alloc(sizeof(QCC_Program));
+  *p = (QCC_Program) { .sm=sm, .threads=threads, .n=0, .steps=QCC_alloc(sizeof(QCC_Step) * (n ? n : 1)),
+                       .lastIdx=-1, .step=0, .stepIdx=0 };
+  return p;
+}
+
+/* Append a copy of the step s to p, sharing its argument */
+static QCC_Step* QCC_copyStep(QCC_Program *p, QCC_Step *s) {
+  QCC_Step *c = &p->steps[p->n++];
+  *c = *s;
+  c->ran = QCC_FALSE;
+  if (c->arg) c->arg->refs++;
+  return c;
+}
+
+static void QCC_freeProgram(void *value) {
+  QCC_Program *p = value;
+  int i;
+
+  for (i=0; i<p->n; i++)
+    if (p->steps[i].arg) QCC_release(p->steps[i].arg);
+  QCC_freeAlloc(p->steps);
+  QCC_freeAlloc(p);
+}
+
+static void QCC_writeStep(QCC_Sink *sink, const QCC_StateMachine *sm, QCC_Step *s) {
+  const char *name = sm->commands[s->command].name;
+
+  QCC_sinkWrite(sink, name, strlen(name));
+  QCC_sinkWrite(sink, "(", 1);
+  if (s->arg) QCC_writeGenValue(sink, s->arg->value);
+  QCC_sinkWrite(sink, ")", 1);
+  if (s->ran) {
+    QCC_sinkWrite(sink, " -> ", 4);
+    QCC_writeDecimal(sink, s->result);
+  }
+}
+
+/* Sequential programs are written as a list of steps, parallel ones as one list per thread */
+static void QCC_writeProgram(QCC_Sink *sink, void *value, int len) {
+  QCC_Program *p = value;
+  int t, i, first;
+
+  for (t=0; t<=p->threads; t++) {
+    if (p->threads) {
+      if (t) QCC_sinkPrintf(sink, "\nThread %d: ", t);
+      else QCC_sinkWrite(sink, "Prefix: ", 8);
+    }
+    QCC_sinkWrite(sink, "[", 1);
+    for (i=0, first=1; i<p->n; i++) {
+      if (p->steps[i].thread != t) continue;
+      if (!first) QCC_sinkWrite(sink, ", ", 2);
+      QCC_writeStep(sink, p->sm, &p->steps[i]);
+      first = 0;
+    }
+    QCC_sinkWrite(sink, "]", 1);
+  }
+}
+
+static char* QCC_showProgram(void *value, int len) {
+  return QCC_showWritten(QCC_writeProgram, value, len);
+}
+
+static uint64_t QCC_hashProgram(void *value, int len) {
+  QCC_Program *p = value;
+  uint64_t h = (uint64_t) p->n;
+  int i;
+
+  for (i=0; i<p->n; i++) {
+    h = QCC_hashMix(h, ((uint64_t) p->steps[i].command << 8) | (uint64_t) p->steps[i].thread);
+    if (p->steps[i].arg) h = QCC_hashMix(h, QCC_hashGenValue(p->steps[i].arg->value));
+  }
+  return h;
+}
+
+static QCC_GenValue* QCC_programValue(QCC_Program *p) {
+  return QCC_initShrinkableValue(p, p->n, QCC_showProgram, QCC_writeProgram, QCC_freeProgram,
+                                 QCC_shrinkProgram, NULL, QCC_hashProgram);
+}
+
+/*
+ * Append to p a step of thread t, chosen among the commands enabled in
+ * the state of model, which it updates. Returns 0 if no command is
+ * enabled, -1 if the generator of its argument failed.
+ */
+static int QCC_genStep(QCC_Program *p, int t, void *model, int *enabled) {
+  const QCC_StateMachine *sm = p->sm;
+  const QCC_Command *cmd;
+  QCC_GenValue *arg = NULL;
+  int i, enabledN = 0;
+
+  for (i=0; i<sm->commandsN; i++)
+    if (!sm->commands[i].pre || sm->commands[i].pre(model)) enabled[enabledN++] = i;
+  if (!enabledN) return 0;
+  i = enabled[QCC_choose(enabledN)];
+  cmd = &sm->commands[i];
+  if (cmd->gen && !(arg = cmd->gen(model))) return -1;
+
+  p->steps[p->n++] = (QCC_Step) { .command=i, .thread=t, .arg=arg ? QCC_share(arg) : NULL,
+                                  .result=0, .invoked=0, .returned=0, .ran=QCC_FALSE };
+  if (cmd->next) cmd->next(model, arg);
+  return 1;
+}
+
+/*
+ * Generate a program of the current machine, running its model: a
+ * sequence of steps, or a prefix and a branch per thread if the program is
+ * parallel. Lengths grow with the generation size.
+ */
+static QCC_GenValue* QCC_genProgram() {
+  const QCC_StateMachine *sm = QCC_currentMachine;
+  int threads = QCC_currentThreads;
+  QCC_Rng *rng = QCC_getRng();
+  int lengths[QCC_MAX_STATE_THREADS + 1];
+  int branch = threads ? QCC_STATE_MAX_PARALLEL / threads : 0;
+  int *enabled = malloc(sizeof(int) * (sm->commandsN ? sm->commandsN : 1));
+  void *model = malloc(sm->modelSize ? sm->modelSize : 1);
+  QCC_Program *p;
+  int n = 0, status = 1, t, k;
+
+  if (branch > QCC_STATE_MAX_BRANCH) branch = QCC_STATE_MAX_BRANCH;
+  lengths[0] = QCC_rngLength(rng, (threads ? QCC_STATE_MAX_PREFIX : QCC_STATE_MAX_STEPS) + 1);
+  for (t=1; t<=threads; t++) lengths[t] = 1 + QCC_rngLength(rng, branch);
+  for (t=0; t<=threads; t++) n += lengths[t];
+
+  p = QCC_newProgram(sm, threads, n);
+  QCC_initModel(sm, model);
+  for (t=0; t<=threads && status >= 0; t++)
+    for (k=0; k<lengths[t] && (status = QCC_genStep(p, t, model, enabled)) > 0; k++);
+  free(enabled);
+  free(model);
+
+  if (status < 0) {
+    QCC_freeProgram(p);
+    return NULL;
+  }
+  return QCC_programValue(p);
+}
+
+/*
+ * Shrink candidates of a program: chunks of steps removed as for arrays,
+ * then the first step of each branch moved to the end of the prefix, then
+ * the arguments of the steps shrunk in order.
+ */
+static QCC_GenValue* QCC_shrinkProgram(QCC_GenValue *gv, int idx) {
+  QCC_Program *p = gv->value, *c;
+  QCC_GenValue *arg, *a;
+  int prefix, k, i, t;
+
+  for (k=p->n; k>0; k/=2) {
+    int chunks = (p->n + k - 1) / k;
+    if (idx < chunks) {
+      c = QCC_newProgram(p->sm, p->threads, p->n);
+      for (i=0; i<p->n; i++)
+        if (i < idx*k || i >= (idx+1)*k) QCC_copyStep(c, &p->steps[i]);
+      return QCC_programValue(c);
+    }
+    idx -= chunks;
+  }
+
+  for (prefix=0; prefix<p->n && p->steps[prefix].thread == 0; prefix++);
+  for (t=1; t<=p->threads; t++) {
+    for (k=prefix; k<p->n && p->steps[k].thread != t; k++);
+    if (k == p->n || idx-- > 0) continue;
+    c = QCC_newProgram(p->sm, p->threads, p->n);
+    for (i=0; i<prefix; i++) QCC_copyStep(c, &p->steps[i]);
+    QCC_copyStep(c, &p->steps[k])->thread = 0;
+    for (i=prefix; i<p->n; i++)
+      if (i != k) QCC_copyStep(c, &p->steps[i]);
+    return QCC_programValue(c);
+  }
+
+  if (idx <= p->lastIdx) {
+    p->lastIdx = -1;
+    p->step = p->stepIdx = 0;
+  }
+  while (p->step < p->n) {
+    arg = QCC_stepArg(&p->steps[p->step]);
+    if (!arg || !arg->shrink || !(a = arg->shrink(arg, p->stepIdx))) {
+      p->step++;
+      p->stepIdx = 0;
+      continue;
+    }
+    p->stepIdx++;
+    if (++p->lastIdx < idx) {
+      QCC_freeGenValue(a);
+      continue;
+    }
+    c = QCC_newProgram(p->sm, p->threads, p->n);
+    for (i=0; i<p->n; i++) {
+      if (i != p->step) QCC_copyStep(c, &p->steps[i]);
+      else c->steps[c->n++] = (QCC_Step) { .command=p->steps[i].command, .thread=p->steps[i].thread,
+                                           .arg=QCC_share(a), .ran=QCC_FALSE };
+    }
+    return QCC_programValue(c);
+  }
+  return NULL;
 }
 
-static void QCC_printStamps(QCC_Stamp *stamps, int n) {
-  QCC_Stamp *sortedStamps = QCC_sortStamp(stamps);
-  QCC_Stamp *tstamps;
-  for (tstamps=sortedStamps; tstamps != NULL; tstamps=tstamps->next)
-    printf("%.2f%%\t%s\n", (tstamps->n/(float)n)*100, tstamps->label);
-  if (sortedStamps) QCC_freeStamp(sortedStamps);
+/*
+ * Whether the preconditions of the steps of p hold in generation order,
+ * which shrinking may have broken.
+ */
+static QCC_Boolean QCC_validProgram(QCC_Program *p, void *model) {
+  const QCC_Command *cmd;
+  int i;
+
+  QCC_initModel(p->sm, model);
+  for (i=0; i<p->n; i++) {
+    cmd = &p->sm->commands[p->steps[i].command];
+    if (cmd->pre && !cmd->pre(model)) return QCC_FALSE;
+    if (cmd->next) cmd->next(model, QCC_stepArg(&p->steps[i]));
+  }
+  return QCC_TRUE;
 }
 
-static void QCC_printArguments(QCC_GenValue **arguments, int argumentsN) {
+/*
+ * Run the steps [from, to) of p on sut in order, checking their results
+ * against model, which they update. Returns whether all the
+ * postconditions held.
+ */
+static QCC_Boolean QCC_runSteps(QCC_Program *p, int from, int to, void *sut, void *model) {
+  const QCC_Command *cmd;
+  QCC_Step *s;
   int i;
-  for (i=0; i<argumentsN; i++) {
-    char *s = arguments[i]->show(arguments[i]->value, arguments[i]->n);
-    printf("%s\n", s);
-    free(s);
+
+  for (i=from; i<to; i++) {
+    s = &p->steps[i];
+    cmd = &p->sm->commands[s->command];
+    s->result = cmd->run(sut, QCC_stepArg(s));
+    s->ran = QCC_TRUE;
+    if (cmd->post && !cmd->post(model, QCC_stepArg(s), s->result)) return QCC_FALSE;
+    if (cmd->next) cmd->next(model, QCC_stepArg(s));
   }
+  return QCC_TRUE;
 }
 
-int QCC_testForAll(int num, int maxFail, QCC_property prop, int genNum, ...) {
+static void* QCC_stateWorker(void *arg) {
+  QCC_StateWorker *w = arg;
+  QCC_StatePool *pool = w->pool;
+  QCC_Program *p;
+  QCC_Step *s;
+  int i;
+
+  for (;;) {
+    pthread_barrier_wait(&pool->start);
+    if (pool->stop) break;
+    p = pool->program;
+    for (i=0; i<p->n; i++) {
+      s = &p->steps[i];
+      if (s->thread != w->branch) continue;
+      s->invoked = atomic_fetch_add(&pool->clock, 1);
+      s->result = p->sm->commands[s->command].run(pool->sut, QCC_stepArg(s));
+      s->returned = atomic_fetch_add(&pool->clock, 1);
+      s->ran = QCC_TRUE;
+    }
+    pthread_barrier_wait(&pool->done);
+  }
+  return NULL;
+}
+
+/*
+ * Pool of the calling thread, started on first use. Processes forked in
+ * isolation mode don't have the threads of the pool of their parent and
+ * start their own.
+ */
+static QCC_StatePool* QCC_getStatePool(int threads) {
+  QCC_StatePool *pool = QCC_statePool;
+  int i;
+
+  if (pool && pool->pid == getpid()) return pool;
+  pool = malloc(sizeof(QCC_StatePool));
+  pool->workers = calloc(threads, sizeof(QCC_StateWorker));
+  pool->n = threads;
+  pool->pid = getpid();
+  pool->program = NULL;
+  pool->sut = NULL;
+  pool->stop = QCC_FALSE;
+  atomic_init(&pool->clock, 0);
+  pthread_barrier_init(&pool->start, NULL, threads + 1);
+  pthread_barrier_init(&pool->done, NULL, threads + 1);
+  for (i=0; i<threads; i++) {
+    pool->workers[i].branch = i + 1;
+    pool->workers[i].pool = pool;
+    pthread_create(&pool->workers[i].thread, NULL, QCC_stateWorker, &pool->workers[i]);
+  }
+  return QCC_statePool = pool;
+}
+
+static void QCC_stopStatePool() {
+  QCC_StatePool *pool = QCC_statePool;
+  int i;
+
+  QCC_statePool = NULL;
+  if (!pool || pool->pid != getpid()) return;
+  pool->stop = QCC_TRUE;
+  pthread_barrier_wait(&pool->start);
+  for (i=0; i<pool->n; i++) pthread_join(pool->workers[i].thread, NULL);
+  pthread_barrier_destroy(&pool->start);
+  pthread_barrier_destroy(&pool->done);
+  free(pool->workers);
+  free(pool);
+}
+
+/*
+ * Search an order of the steps of h not in done explaining their results,
+ * from the state of the model at depth (the number of steps in done).
+ * Only the steps invoked before the earliest return of a pending step can
+ * come next. States reached (model and done set) are remembered, as
+ * reaching one again along another order can't succeed either.
+ */
+static QCC_Boolean QCC_linearize(QCC_History *h, uint64_t done, int depth) {
+  size_t size = h->sm->modelSize;
+  uint8_t *model = h->models + depth*size, *next = model + size;
+  uint64_t earliest = UINT64_MAX, key;
+  const QCC_Command *cmd;
+  QCC_GenValue *arg;
+  QCC_Step *s;
+  int i;
+
+  if (depth == h->n) return QCC_TRUE;
+  for (i=0; i<h->n; i++)
+    if (!(done >> i & 1) && h->ops[i]->returned < earliest) earliest = h->ops[i]->returned;
+
+  for (i=0; i<h->n; i++) {
+    s = h->ops[i];
+    if ((done >> i & 1) || s->invoked > earliest) continue;
+    cmd = &h->sm->commands[s->command];
+    arg = QCC_stepArg(s);
+    if ((cmd->pre && !cmd->pre(model)) || (cmd->post && !cmd->post(model, arg, s->result))) continue;
+
+    memcpy(next, model, size);
+    if (cmd->next) cmd->next(next, arg);
+    key = QCC_hashMix(QCC_hashBytes(next, size), done | 1ULL << i);
+    key = QCC_splitMix64(&key);
+    if (!key) key = 1;
+    if (h->explored.used * 2 >= h->explored.size) QCC_growCaseSet(&h->explored, 0);
+    if (QCC_caseSetInsert(&h->explored, key)) continue;
+    if (QCC_linearize(h, done | 1ULL << i, depth + 1)) return QCC_TRUE;
+  }
+  return QCC_FALSE;
+}
+
+/*
+ * Run p once on a new system under test: the prefix on the calling
+ * thread, the branches on the pool. Returns whether the results are
+ * explained by the model.
+ */
+static QCC_Boolean QCC_runProgram(QCC_Program *p, void *model) {
+  const QCC_StateMachine *sm = p->sm;
+  QCC_History h = { .sm=sm, .n=0, .models=NULL, .explored={ NULL, 0, 0 } };
+  QCC_StatePool *pool;
+  void *sut = sm->newSut();
+  QCC_Boolean ok;
+  int prefix, i;
+
+  for (i=0; i<p->n; i++) p->steps[i].ran = QCC_FALSE;
+  for (prefix=0; prefix<p->n && p->steps[prefix].thread == 0; prefix++);
+  QCC_initModel(sm, model);
+  ok = QCC_runSteps(p, 0, prefix, sut, model);
+
+  if (ok && prefix < p->n) {
+    pool = QCC_getStatePool(p->threads);
+    pool->program = p;
+    pool->sut = sut;
+    pthread_barrier_wait(&pool->start);
+    pthread_barrier_wait(&pool->done);
+
+    for (i=prefix; i<p->n; i++) h.ops[h.n++] = &p->steps[i];
+    h.models = malloc(sm->modelSize * (h.n + 1) + 1);
+    memcpy(h.models, model, sm->modelSize);
+    ok = QCC_linearize(&h, 0, 0);
+    free(h.models);
+    QCC_freeCaseSet(&h.explored);
+  }
+
+  sm->freeSut(sut);
+  return ok;
+}
+
+static QCC_TestStatus QCC_programProperty(QCC_GenValue **vals, int len, QCC_Stamp **stamp) {
+  QCC_Program *p = vals[0]->value;
+  const QCC_StateMachine *sm = p->sm;
+  void *model = malloc(sm->modelSize ? sm->modelSize : 1);
+  QCC_TestStatus status = QCC_OK;
+  int c, i, run;
+
+  if (!QCC_validProgram(p, model)) {
+    free(model);
+    return QCC_NOTHING;
+  }
+  for (c=0; c<sm->commandsN; c++) {
+    for (i=0; i<p->n && p->steps[i].command != c; i++);
+    if (i < p->n) QCC_label(stamp, (char *) sm->commands[c].name);
+  }
+
+  for (run=0; run<(p->threads ? QCC_STATE_RUNS : 1) && status == QCC_OK; run++)
+    if (!QCC_runProgram(p, model)) status = QCC_FAIL;
+  free(model);
+  return status;
+}
+
+static int QCC_runStateMachine(int threads, int num, int maxFail, const QCC_StateMachine *sm) {
+  const QCC_StateMachine *prevMachine = QCC_currentMachine;
+  int prevThreads = QCC_currentThreads;
+  int ret;
+
+  QCC_currentMachine = sm;
+  QCC_currentThreads = threads;
+  ret = QCC_testForAll(num, maxFail, QCC_programProperty, 1, QCC_genProgram);
+  QCC_stopStatePool();
+  QCC_currentThreads = prevThreads;
+  QCC_currentMachine = prevMachine;
+  return ret;
+}
+
+int QCC_testStateMachine(int num, int maxFail, const QCC_StateMachine *sm) {
+  return QCC_runStateMachine(0, num, maxFail, sm);
+}
+
+int QCC_testStateMachineParallel(int threads, int num, int maxFail, const QCC_StateMachine *sm) {
+  if (threads < 2) threads = 2;
+  if (threads > QCC_MAX_STATE_THREADS) threads = QCC_MAX_STATE_THREADS;
+  return QCC_runStateMachine(threads, num, maxFail, sm);
+}
+
+/***********************************************************************
+ *  Performance testing functions
+ ***********************************************************************/
+#define QCC_LATENCY_RETRIES 3
+#define QCC_CLIMB_TIMINGS 5
+#define QCC_CLIMB_MARGIN 0.05
+#define QCC_CLIMB_SECONDS 1e-5
+#define QCC_CLIMB_MAX_REPS 10000
+
+/*
+ * Property timed by QCC_timedProperty. Evaluations slower than limit (if
+ * positive) fail, so that shrinking keeps the candidates over it.
+ * Evaluations slower than confirm are timed again as well. Runners collect
+ * the times of the successful cases in samples.
+ */
+typedef struct QCC_Latency {
+  QCC_property prop;
+  double limit;
+  double confirm;
+  double seconds;
+  double overSeconds;
+  double *samples;
+  int samplesN;
+  int samplesCap;
+} QCC_Latency;
+
+static _Thread_local QCC_Latency *QCC_currentLatency = NULL;
+
+/*
+ * Evaluate prop, timing it. Evaluations slower than threshold are
+ * repeated up to QCC_LATENCY_RETRIES times while they stay slower and the
+ * fastest one counts, so that a preemption or a cold cache doesn't make a
+ * case look slow.
+ */
+static QCC_TestStatus QCC_timeProperty(QCC_property prop, QCC_GenValue **vals, int len, QCC_Stamp **stamps,
+                                       double threshold, double *seconds) {
+  QCC_TestStatus status;
+  double start, elapsed;
+  int i = 0;
+
+  *seconds = HUGE_VAL;
+  do {
+    if (i) QCC_resetStamp(*stamps);
+    start = QCC_now();
+    status = prop(vals, len, stamps);
+    elapsed = QCC_now() - start;
+    if (elapsed < *seconds) *seconds = elapsed;
+  } while (++i < QCC_LATENCY_RETRIES && status == QCC_OK && *seconds > threshold);
+  return status;
+}
+
+static QCC_TestStatus QCC_timedProperty(QCC_GenValue **vals, int len, QCC_Stamp **stamps) {
+  QCC_Latency *l = QCC_currentLatency;
+  double threshold = l->limit > 0 ? l->limit : (l->confirm > 0 ? l->confirm : HUGE_VAL);
+  QCC_TestStatus status = QCC_timeProperty(l->prop, vals, len, stamps, threshold, &l->seconds);
+
+  if (status != QCC_OK || l->limit <= 0 || l->seconds <= l->limit) return status;
+  l->overSeconds = l->seconds;
+  return QCC_FAIL;
+}
+
+static void QCC_addSample(QCC_Latency *l, double seconds) {
+  if (l->samplesN == l->samplesCap) {
+    l->samplesCap = l->samplesCap ? 2*l->samplesCap : 256;
+    l->samples = realloc(l->samples, sizeof(double) * l->samplesCap);
+  }
+  l->samples[l->samplesN++] = seconds;
+}
+
+/* Nearest rank percentile p of the n sorted samples */
+static double QCC_percentile(double *sorted, int n, double p) {
+  int rank = (int) (p * n);
+  if (!n) return 0;
+  if (rank < p * n) rank++;
+  return sorted[rank < 1 ? 0 : (rank > n ? n - 1 : rank - 1)];
+}
+
+/*
+ * Regenerate the case caseIndex of plan, whose time is taken again, and
+ * shrink it with the timed property as set up in l, to a smaller case
+ * still over the budget.
+ */
+static void QCC_reportSlowCase(QCC_Plan *plan, int64_t caseIndex, QCC_Latency *l) {
+  QCC_Result res = { .status=QCC_FAIL, .stamps=NULL, .arguments=plan->vals, .argumentsN=plan->genNum };
+  QCC_Arena *prevArena;
+  QCC_ShrinkStats stats;
+  QCC_Stamp *stamps = NULL;
+
+  QCC_regeneratePlan(plan, QCC_indexCase(plan->runSeed, caseIndex), caseIndex);
+  prevArena = QCC_useArena(plan->arena);
+  QCC_timeProperty(l->prop, plan->vals, plan->genNum, &stamps, 0, &l->overSeconds);
+  QCC_freeStamp(stamps);
+
+  stats = QCC_shrinkResult(QCC_timedProperty, &res);
+  QCC_reportf("Slowest case (%.1fus):\n", l->overSeconds * 1e6);
+  QCC_printArguments(res.arguments, res.argumentsN);
+  if (stats.steps)
+    QCC_reportf("Shrunk %d times in %d steps (%.3fs%s)\n", stats.shrinks, stats.steps, stats.seconds,
+                stats.exhausted ? ", budget exhausted" : "");
+  QCC_reportf("Run seed 0x%016llx, case %lld, size %d (see QCC_replay)\n",
+              (unsigned long long) plan->runSeed, (long long) caseIndex, plan->size);
+  QCC_useArena(prevArena);
+}
+
+static void QCC_reportLatencies(QCC_Latency *l) {
+  int n = l->samplesN;
+  if (!n) return;
+  qsort(l->samples, n, sizeof(double), QCC_compareDouble);
+  QCC_reportf("Latency p50 %.1fus, p90 %.1fus, p99 %.1fus, max %.1fus\n",
+              QCC_percentile(l->samples, n, 0.5) * 1e6, QCC_percentile(l->samples, n, 0.9) * 1e6,
+              QCC_percentile(l->samples, n, 0.99) * 1e6, l->samples[n-1] * 1e6);
+}
+
+int QCC_testLatency(int num, int maxFail, QCC_LatencyBudget budget, QCC_property prop, int genNum, ...) {
+  QCC_Latency latency = { .prop=prop, .limit=budget.maxSeconds, .confirm=0, .seconds=0, .overSeconds=0, .samples=NULL, .samplesN=0, .samplesCap=0 };
+  QCC_Latency *prevLatency = QCC_currentLatency;
+  int64_t slowest = -1;
+  double slowestSeconds = 0, p;
   va_list genP;
-  int succ = 0;
-  int fail = 0;
+  int ret;
+
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(QCC_timedProperty, genNum, genP);
+  va_end(genP);
+
+  QCC_currentLatency = &latency;
+  QCC_resetPlan(plan);
+  while (plan->status != QCC_FAIL && plan->succ < num && plan->fail < maxFail) {
+    if (QCC_planStep(plan) != QCC_OK) continue;
+    QCC_addSample(&latency, latency.seconds);
+    if (latency.seconds > slowestSeconds) {
+      slowestSeconds = latency.seconds;
+      slowest = plan->caseIndex;
+    }
+  }
+
+  ret = QCC_report(num, maxFail, plan->succ, plan->fail, &plan->discards,
+                   plan->status == QCC_FAIL ? plan : NULL, plan->stamps);
+  if (plan->status == QCC_FAIL && latency.overSeconds > 0) {
+    QCC_reportf("Took %.1fus, over the budget of %.1fus\n", latency.overSeconds * 1e6, budget.maxSeconds * 1e6);
+  } else if (ret == 0) {
+    QCC_reportLatencies(&latency);
+    p = QCC_percentile(latency.samples, latency.samplesN, budget.percentile);
+    if (budget.percentileSeconds > 0 && p > budget.percentileSeconds) {
+      QCC_reportf("Latency p%g %.1fus over the budget of %.1fus\n",
+                  budget.percentile * 100, p * 1e6, budget.percentileSeconds * 1e6);
+      /* The slowest case shrinks as long as it stays over the percentile budget */
+      latency.limit = budget.percentileSeconds;
+      QCC_reportSlowCase(plan, slowest, &latency);
+      ret = 1;
+    }
+  }
+
+  QCC_currentLatency = prevLatency;
+  free(latency.samples);
+  QCC_freePlan(plan);
+  return ret;
+}
 
-  QCC_Result res = { .status=QCC_OK };
+/*
+ * Mean time of reps evaluations of prop, stopping at the first one that
+ * doesn't pass, whose status is stored. Labels are dropped.
+ */
+static double QCC_timeRepeated(QCC_property prop, QCC_GenValue **vals, int len, int reps,
+                               QCC_Stamp **stamps, QCC_TestStatus *status) {
+  double start = QCC_now(), elapsed;
+  int i;
+
+  *status = QCC_OK;
+  for (i=0; i<reps && *status == QCC_OK; i++) *status = prop(vals, len, stamps);
+  elapsed = (QCC_now() - start) / i;
+  QCC_resetStamp(*stamps);
+  return elapsed;
+}
+
+/*
+ * Whether prop passes and is slower on the arguments cand than on vals.
+ * Both sides are timed QCC_CLIMB_TIMINGS times over reps evaluations,
+ * interleaved so that they run in the same conditions: cand is slower if
+ * all its timings are slower than those of vals, which happens by chance
+ * once in 252 comparisons of equal arguments, and its fastest timing is
+ * slower than the fastest of vals by QCC_CLIMB_MARGIN at least. The
+ * fastest time of cand is stored in seconds.
+ */
+static QCC_Boolean QCC_climbSlower(QCC_property prop, QCC_GenValue **vals, QCC_GenValue **cand, int len, int reps,
+                                   double *seconds) {
   QCC_Stamp *stamps = NULL;
-  while (succ < num && fail < maxFail) {
-    va_start(genP, genNum);
-    res = QCC_vforAll(prop, genNum, genP);
-    va_end(genP);
+  QCC_TestStatus status = QCC_OK, ignored;
+  double base = HUGE_VAL, baseMax = 0, t;
+  int i;
 
-    if (res.status == QCC_FAIL) {
-      break;
+  *seconds = HUGE_VAL;
+  for (i=0; i<QCC_CLIMB_TIMINGS && status == QCC_OK; i++) {
+    t = QCC_timeRepeated(prop, vals, len, reps, &stamps, &ignored);
+    if (t < base) base = t;
+    if (t > baseMax) baseMax = t;
+    t = QCC_timeRepeated(prop, cand, len, reps, &stamps, &status);
+    if (t < *seconds) *seconds = t;
+  }
+  QCC_freeStamp(stamps);
+  return status == QCC_OK && *seconds > baseMax && *seconds > base * (1 + QCC_CLIMB_MARGIN);
+}
+
+/*
+ * Climb from the arguments vals towards slower ones, within the shrinking
+ * budget: each step mutates one of the arguments that can be mutated,
+ * drawing the mutation from rng, and keeps the mutated arguments if the
+ * property passes and is slower on them (see QCC_climbSlower). Fast
+ * properties are evaluated repeatedly for QCC_CLIMB_SECONDS at least per
+ * timing, so that timings are well over the resolution of the clock. The
+ * fastest time of the resulting arguments is stored in seconds.
+ */
+static QCC_ShrinkStats QCC_climb(QCC_property prop, QCC_GenValue **vals, int len, QCC_Rng *rng, double *seconds) {
+  QCC_ShrinkStats stats = { .shrinks=0, .steps=0, .seconds=0, .exhausted=QCC_FALSE };
+  QCC_GenValue **cand = malloc(sizeof(QCC_GenValue *) * (len ? len : 1));
+  int *mutable = malloc(sizeof(int) * (len ? len : 1));
+  QCC_GenValue *mutated;
+  QCC_Stamp *stamps = NULL;
+  QCC_TestStatus status;
+  double start = QCC_now(), t;
+  int mutableN = 0, reps = 1, i, k;
+
+  for (i=0; i<len; i++) {
+    cand[i] = vals[i];
+    if (vals[i]->mutate) mutable[mutableN++] = i;
+  }
+  for (; reps < QCC_CLIMB_MAX_REPS; reps *= 2)
+    if (QCC_timeRepeated(prop, vals, len, reps, &stamps, &status) * reps >= QCC_CLIMB_SECONDS) break;
+  *seconds = HUGE_VAL;
+  for (k=0; k<QCC_CLIMB_TIMINGS; k++) {
+    t = QCC_timeRepeated(prop, vals, len, reps, &stamps, &status);
+    if (t < *seconds) *seconds = t;
+  }
+  QCC_freeStamp(stamps);
+
+  while (mutableN && stats.steps < QCC_shrinkMaxSteps &&
+         (QCC_shrinkMaxSeconds <= 0 || QCC_now() - start < QCC_shrinkMaxSeconds)) {
+    i = mutable[QCC_rngBelow(rng, mutableN)];
+    stats.steps++;
+    if (!(mutated = vals[i]->mutate(vals[i], rng))) continue;
+    cand[i] = mutated;
+    if (QCC_climbSlower(prop, vals, cand, len, reps, &t)) {
+      QCC_freeGenValue(vals[i]);
+      vals[i] = mutated;
+      *seconds = t;
+      stats.shrinks++;
     } else {
-      if (res.status == QCC_OK) {
-        succ++;
-        QCC_mergeLabels(&stamps, res.stamps);
-      } else fail++;
-      QCC_freeResult(&res);
+      QCC_freeGenValue(mutated);
+      cand[i] = vals[i];
     }
   }
+  stats.seconds = QCC_now() - start;
 
-  if (succ == num) {
-    printf("%d test passed (%d)!\n", succ, fail);
-    QCC_printStamps(stamps, succ);
-    if (stamps) QCC_freeStamp(stamps);
-    return 0;
-  } else if (res.status == QCC_FAIL) {
-    printf("Falsifiable after %d test\n", succ+1);
-    QCC_printArguments(res.arguments, res.argumentsN);
-    QCC_freeResult(&res);
-    if (stamps) QCC_freeStamp(stamps);
+  free(cand);
+  free(mutable);
+  return stats;
+}
+
+/*
+ * Regenerate the case caseIndex of plan and climb from it. Mutations are
+ * drawn from a generator of their own seeded from the case, so that
+ * searches can be repeated. The time of the resulting arguments is
+ * returned.
+ */
+static double QCC_reportClimbedCase(QCC_Plan *plan, int64_t caseIndex, QCC_property prop) {
+  QCC_Case c = QCC_indexCase(plan->runSeed, caseIndex);
+  QCC_Arena *prevArena;
+  QCC_ShrinkStats stats;
+  QCC_Rng rng;
+  double seconds;
+
+  QCC_regeneratePlan(plan, c, caseIndex);
+  prevArena = QCC_useArena(plan->arena);
+  QCC_rngSeed(&rng, ~c.seed);
+  stats = QCC_climb(prop, plan->vals, plan->genNum, &rng, &seconds);
+
+  QCC_reportf("Slowest case (%.1fus):\n", seconds * 1e6);
+  QCC_printArguments(plan->vals, plan->genNum);
+  if (stats.steps)
+    QCC_reportf("Climbed %d times in %d steps (%.3fs)\n", stats.shrinks, stats.steps, stats.seconds);
+  /* Replays reproduce the case the climb started from */
+  if (stats.shrinks)
+    QCC_reportf("Climbed from run seed 0x%016llx, case %lld, size %d (see QCC_replay)\n",
+                (unsigned long long) plan->runSeed, (long long) caseIndex, plan->size);
+  else
+    QCC_reportf("Run seed 0x%016llx, case %lld, size %d (see QCC_replay)\n",
+                (unsigned long long) plan->runSeed, (long long) caseIndex, plan->size);
+  QCC_useArena(prevArena);
+  return seconds;
+}
+
+int QCC_searchWorstCase(int num, int maxFail, double budget, QCC_property prop, int genNum, ...) {
+  QCC_Latency latency = { .prop=prop, .limit=0, .confirm=0, .seconds=0, .overSeconds=0,
+                          .samples=NULL, .samplesN=0, .samplesCap=0 };
+  QCC_Latency *prevLatency = QCC_currentLatency;
+  int64_t slowest = -1;
+  double seconds;
+  va_list genP;
+  int ret;
+
+  va_start(genP, genNum);
+  QCC_Plan *plan = QCC_vnewPlan(QCC_timedProperty, genNum, genP);
+  va_end(genP);
+
+  QCC_currentLatency = &latency;
+  QCC_resetPlan(plan);
+  while (plan->status != QCC_FAIL && plan->succ < num && plan->fail < maxFail) {
+    if (QCC_planStep(plan) != QCC_OK || latency.seconds <= latency.confirm) continue;
+    latency.confirm = latency.seconds;
+    slowest = plan->caseIndex;
+  }
+
+  ret = QCC_report(num, maxFail, plan->succ, plan->fail, &plan->discards,
+                   plan->status == QCC_FAIL ? plan : NULL, plan->stamps);
+  if (ret == 0 && slowest >= 0) {
+    seconds = QCC_reportClimbedCase(plan, slowest, prop);
+    if (budget > 0 && seconds > budget) {
+      QCC_reportf("Over the budget of %.1fus\n", budget * 1e6);
+      ret = 1;
+    }
+  }
+
+  QCC_currentLatency = prevLatency;
+  QCC_freePlan(plan);
+  return ret;
+}
+
+/***********************************************************************
+ *  Benchmark functions
+ ***********************************************************************/
+#define QCC_BENCH_MIN_SAMPLES 30
+#define QCC_BENCH_SAMPLE_SECONDS 1e-3
+#define QCC_BENCH_RESAMPLES 1000
+
+static double QCC_benchWarmup = 0.1;
+static double QCC_benchMeasure = 1.0;
+static char *QCC_baselinePath = NULL;
+static double QCC_baselineTolerance = 0.05;
+static QCC_Boolean QCC_baselineUpdate = QCC_FALSE;
+
+void QCC_setBenchTime(double warmupSeconds, double measureSeconds) {
+  QCC_benchWarmup = warmupSeconds > 0 ? warmupSeconds : 0;
+  QCC_benchMeasure = measureSeconds > 0 ? measureSeconds : 1.0;
+}
+
+void QCC_setBenchBaseline(const char *path, double tolerance, QCC_Boolean update) {
+  free(QCC_baselinePath);
+  QCC_baselinePath = path ? strdup(path) : NULL;
+  QCC_baselineTolerance = tolerance > 0 ? tolerance : 0;
+  QCC_baselineUpdate = update;
+}
+
+/*
+ * Inputs of a benchmark, generated once as the cases of a run are: genNum
+ * arguments per input, input i starting at vals + i*genNum.
+ */
+typedef struct QCC_BenchPool {
+  QCC_GenValue **vals;
+  int genNum;
+  int n;
+} QCC_BenchPool;
+
+typedef struct QCC_BenchStats {
+  int samples;
+  uint64_t opsPerSample;
+  double mean;
+  double ciLow;
+  double ciHigh;
+  double median;
+  double min;
+  int mildOutliers;
+  int severeOutliers;
+} QCC_BenchStats;
+
+/* Generate size inputs, giving up after as many discarded ones */
+static QCC_Boolean QCC_newBenchPool(QCC_BenchPool *pool, int size, int genNum, va_list genP) {
+  QCC_gen *gens = malloc(sizeof(QCC_gen) * (genNum ? genNum : 1));
+  uint64_t runSeed = QCC_rngNext(QCC_getRng());
+  uint64_t i;
+  int j;
+
+  for (j=0; j<genNum; j++) gens[j] = va_arg(genP, QCC_gen);
+  *pool = (QCC_BenchPool) { .vals=malloc(sizeof(QCC_GenValue *) * ((size_t) size * genNum + 1)),
+                            .genNum=genNum, .n=0 };
+  for (i=0; pool->n < size && i < 2 * (uint64_t) size; i++) {
+    QCC_GenValue **vals = pool->vals + (size_t) pool->n * genNum;
+    QCC_Case c = { .seed=QCC_caseSeed(runSeed, i), .size=QCC_caseSize(i), .edge=-1 };
+    if (QCC_generateCase(gens, genNum, c, vals)) pool->n++;
+    else for (j=0; j<genNum; j++) QCC_freeGenValue(vals[j]);
+  }
+  free(gens);
+  return pool->n == size;
+}
+
+static void QCC_freeBenchPool(QCC_BenchPool *pool) {
+  int i;
+  for (i=0; i<pool->n * pool->genNum; i++) QCC_freeGenValue(pool->vals[i]);
+  free(pool->vals);
+}
+
+/* Run fn ops times, on the inputs of pool in turn from *next, returns the seconds taken */
+static double QCC_benchRun(QCC_benchFunction fn, QCC_BenchPool *pool, uint64_t ops, int *next) {
+  double start = QCC_now();
+  uint64_t i;
+
+  for (i=0; i<ops; i++) {
+    fn(pool->vals + (size_t) *next * pool->genNum, pool->genNum);
+    if (++*next == pool->n) *next = 0;
+  }
+  return QCC_now() - start;
+}
+
+/*
+ * 95% confidence interval of the mean of the n samples, from the means of
+ * QCC_BENCH_RESAMPLES resamples with replacement (bootstrap). The
+ * resamples are drawn from their own generator, so that measuring leaves
+ * the thread generator alone.
+ */
+static void QCC_bootstrapMean(double *samples, int n, double *low, double *high) {
+  double *means = malloc(sizeof(double) * QCC_BENCH_RESAMPLES);
+  QCC_Rng rng;
+  double sum;
+  int r, i;
+
+  QCC_rngSeed(&rng, (uint64_t) n);
+  for (r=0; r<QCC_BENCH_RESAMPLES; r++) {
+    for (i=0, sum=0; i<n; i++) sum += samples[QCC_rngBelow(&rng, n)];
+    means[r] = sum / n;
+  }
+  qsort(means, QCC_BENCH_RESAMPLES, sizeof(double), QCC_compareDouble);
+  *low = QCC_percentile(means, QCC_BENCH_RESAMPLES, 0.025);
+  *high = QCC_percentile(means, QCC_BENCH_RESAMPLES, 0.975);
+  free(means);
+}
+
+/*
+ * Statistics of the n samples (seconds per operation), sorted in place.
+ * Outliers are the samples out of the Tukey fences: further than 1.5
+ * (mild) or 3 (severe) interquartile ranges from the quartiles.
+ */
+static QCC_BenchStats QCC_benchStats(double *samples, int n, uint64_t opsPerSample) {
+  QCC_BenchStats stats = { .samples=n, .opsPerSample=opsPerSample, .mean=0, .mildOutliers=0, .severeOutliers=0 };
+  double q1, q3, iqr, d;
+  int i;
+
+  for (i=0; i<n; i++) stats.mean += samples[i];
+  stats.mean /= n;
+  QCC_bootstrapMean(samples, n, &stats.ciLow, &stats.ciHigh);
+
+  qsort(samples, n, sizeof(double), QCC_compareDouble);
+  stats.min = samples[0];
+  stats.median = QCC_percentile(samples, n, 0.5);
+  q1 = QCC_percentile(samples, n, 0.25);
+  q3 = QCC_percentile(samples, n, 0.75);
+  iqr = q3 - q1;
+  for (i=0; i<n; i++) {
+    d = samples[i] < q1 ? q1 - samples[i] : (samples[i] > q3 ? samples[i] - q3 : 0);
+    if (d > 3 * iqr) stats.severeOutliers++;
+    else if (d > 1.5 * iqr) stats.mildOutliers++;
+  }
+  return stats;
+}
+
+/*
+ * The baseline file holds a line per benchmark: its name, then the mean
+ * and confidence interval bounds of its time per operation in
+ * nanoseconds, separated by tabs.
+ */
+static QCC_Boolean QCC_loadBaseline(const char *name, QCC_BenchStats *baseline) {
+  QCC_Boolean found = QCC_FALSE;
+  char *line = NULL, *tab;
+  size_t cap = 0;
+  ssize_t len;
+  FILE *f;
+
+  if (!QCC_baselinePath || !(f = fopen(QCC_baselinePath, "r"))) return QCC_FALSE;
+  while (!found && (len = getline(&line, &cap, f)) > 0) {
+    if (!(tab = strchr(line, '\t')) || (size_t) (tab - line) != strlen(name) ||
+        strncmp(line, name, tab - line) != 0) continue;
+    found = sscanf(tab + 1, "%lf\t%lf\t%lf", &baseline->mean, &baseline->ciLow, &baseline->ciHigh) == 3;
+  }
+  free(line);
+  fclose(f);
+  if (found) {
+    baseline->mean *= 1e-9;
+    baseline->ciLow *= 1e-9;
+    baseline->ciHigh *= 1e-9;
+  }
+  return found;
+}
+
+/* Replace the line of the benchmark name in the baseline file, through a temporary file renamed over it */
+static void QCC_saveBaseline(const char *name, QCC_BenchStats *stats) {
+  size_t pathLen = strlen(QCC_baselinePath);
+  char *tmp = malloc(pathLen + 5);
+  char *line = NULL, *tab;
+  size_t cap = 0;
+  FILE *in, *out;
+
+  memcpy(tmp, QCC_baselinePath, pathLen);
+  memcpy(tmp + pathLen, ".tmp", 5);
+  if (!(out = fopen(tmp, "w"))) {
+    perror(tmp);
+    free(tmp);
+    return;
+  }
+  if ((in = fopen(QCC_baselinePath, "r"))) {
+    while (getline(&line, &cap, in) > 0) {
+      tab = strchr(line, '\t');
+      if (tab && (size_t) (tab - line) == strlen(name) && strncmp(line, name, tab - line) == 0) continue;
+      fputs(line, out);
+    }
+    fclose(in);
+  }
+  fprintf(out, "%s\t%.3f\t%.3f\t%.3f\n", name, stats->mean * 1e9, stats->ciLow * 1e9, stats->ciHigh * 1e9);
+  if (fclose(out) || rename(tmp, QCC_baselinePath)) perror(QCC_baselinePath);
+  free(line);
+  free(tmp);
+}
+
+/*
+ * Compare stats with the baseline: a change is significant if the
+ * confidence intervals don't overlap, and a regression if the mean is
+ * slower by more than the tolerance too. Returns 1 on regressions.
+ */
+static int QCC_reportBaseline(QCC_BenchStats *stats, QCC_BenchStats *baseline) {
+  double change = stats->mean / baseline->mean - 1;
+  QCC_Boolean significant = stats->ciLow > baseline->ciHigh || stats->ciHigh < baseline->ciLow;
+
+  QCC_reportf("Baseline %.1f ns/op [%.1f, %.1f]: %+.1f%%", baseline->mean * 1e9,
+              baseline->ciLow * 1e9, baseline->ciHigh * 1e9, change * 100);
+  if (!significant) {
+    QCC_reportf(", no significant change\n");
+  } else if (change > QCC_baselineTolerance) {
+    QCC_reportf(", regressed over the tolerance of %.1f%%\n", QCC_baselineTolerance * 100);
     return 1;
-  } else if (fail >= maxFail) {
-    printf("Gave up after %d tests!\n", succ);
-    QCC_printStamps(stamps, succ);
-    if (stamps) QCC_freeStamp(stamps);
+  } else if (change < 0) {
+    QCC_reportf(", faster\n");
+  } else {
+    QCC_reportf(", slower within the tolerance of %.1f%%\n", QCC_baselineTolerance * 100);
+  }
+  return 0;
+}
+
+int QCC_benchForAll(const char *name, int poolSize, QCC_benchFunction fn, int genNum, ...) {
+  QCC_BenchPool pool;
+  QCC_BenchStats stats, baseline;
+  double *samples = NULL, elapsed, start;
+  uint64_t ops, warmupOps = 0;
+  int samplesN = 0, samplesCap = 0, next = 0, ret = 0;
+  va_list genP;
+
+  if (poolSize < 1) poolSize = 1;
+  va_start(genP, genNum);
+  QCC_Boolean generated = QCC_newBenchPool(&pool, poolSize, genNum, genP);
+  va_end(genP);
+  if (!generated) {
+    QCC_reportf("%s: gave up after generating %d of %d inputs!\n", name, pool.n, poolSize);
+    QCC_freeBenchPool(&pool);
     return -1;
   }
 
-  return 0;
+  /* Warmup, a pass over the inputs at least, also estimating how many operations fill a sample */
+  start = QCC_now();
+  elapsed = 0;
+  do {
+    elapsed += QCC_benchRun(fn, &pool, pool.n, &next);
+    warmupOps += pool.n;
+  } while (QCC_now() - start < QCC_benchWarmup);
+  ops = elapsed > 0 ? (uint64_t) (QCC_BENCH_SAMPLE_SECONDS * warmupOps / elapsed) : warmupOps;
+  if (ops < 1) ops = 1;
+
+  start = QCC_now();
+  while (samplesN < QCC_BENCH_MIN_SAMPLES || QCC_now() - start < QCC_benchMeasure) {
+    if (samplesN == samplesCap) {
+      samplesCap = samplesCap ? 2*samplesCap : 64;
+      samples = realloc(samples, sizeof(double) * samplesCap);
+    }
+    samples[samplesN++] = QCC_benchRun(fn, &pool, ops, &next) / ops;
+  }
+  stats = QCC_benchStats(samples, samplesN, ops);
+
+  QCC_reportf("%s: %.1f ns/op [%.1f, %.1f] 95%% CI, median %.1f ns, min %.1f ns, %.0f ops/s\n", name,
+              stats.mean * 1e9, stats.ciLow * 1e9, stats.ciHigh * 1e9, stats.median * 1e9,
+              stats.min * 1e9, 1 / stats.mean);
+  QCC_reportf("%d samples of %llu ops over %d inputs\n", stats.samples,
+              (unsigned long long) stats.opsPerSample, pool.n);
+  if (stats.mildOutliers || stats.severeOutliers)
+    QCC_reportf("Found %d outliers among %d samples (%.1f%%): %d mild, %d severe\n",
+                stats.mildOutliers + stats.severeOutliers, stats.samples,
+                100.0 * (stats.mildOutliers + stats.severeOutliers) / stats.samples,
+                stats.mildOutliers, stats.severeOutliers);
+  if (QCC_loadBaseline(name, &baseline)) ret = QCC_reportBaseline(&stats, &baseline);
+  if (QCC_baselinePath && QCC_baselineUpdate) QCC_saveBaseline(name, &stats);
+
+  free(samples);
+  QCC_freeBenchPool(&pool);
+  return ret;
+}
+
+/***********************************************************************
+ *  Property registry
+ ***********************************************************************/
+typedef struct QCC_Property {
+  char *name;
+  int num;
+  int maxFail;
+  QCC_property prop;
+  int genNum;
+  QCC_gen *gens;
+} QCC_Property;
+
+static QCC_Property *QCC_properties = NULL;
+static int QCC_propertiesN = 0;
+
+void QCC_registerProperty(const char *name, int num, int maxFail, QCC_property prop, int genNum, QCC_gen *gens) {
+  QCC_Property *p;
+
+  if ((QCC_propertiesN & (QCC_propertiesN - 1)) == 0)
+    QCC_properties = realloc(QCC_properties, sizeof(QCC_Property) * (QCC_propertiesN ? 2 * QCC_propertiesN : 1));
+  p = &QCC_properties[QCC_propertiesN++];
+  *p = (QCC_Property) { .name=strdup(name), .num=num, .maxFail=maxFail, .prop=prop, .genNum=genNum,
+                       .gens=malloc(sizeof(QCC_gen) * (genNum ? genNum : 1)) };
+  if (genNum) memcpy(p->gens, gens, sizeof(QCC_gen) * genNum);
+}
+
+/*
+ * Registered properties run as tasks of a pool of threads. Each thread
+ * owns a queue of tasks, dealt round-robin by decreasing estimated cost:
+ * it takes its own tasks from the head, most expensive first, and once
+ * they are over steals from the tail of the queue holding the most queued
+ * cost. Tasks are not created while the pool runs, so a thread finding
+ * all the queues empty is done.
+ */
+#define QCC_COST_PROBES 4
+
+typedef struct QCC_Task {
+  QCC_Property *property;
+  uint64_t seed;
+  double cost;
+  double seconds;
+  int ret;
+} QCC_Task;
+
+typedef struct QCC_TaskQueue {
+  pthread_mutex_t lock;
+  QCC_Task **tasks;
+  int head;
+  int tail;
+  double cost;
+} QCC_TaskQueue;
+
+typedef struct QCC_Scheduler {
+  QCC_TaskQueue *queues;
+  int threads;
+  void (*run)(struct QCC_Scheduler *sched, QCC_Task *task);
+  pthread_mutex_t outputLock;
+  int done;
+  int tasksN;
+} QCC_Scheduler;
+
+typedef struct QCC_SchedulerThread {
+  pthread_t thread;
+  QCC_Scheduler *sched;
+  int idx;
+} QCC_SchedulerThread;
+
+static QCC_Task* QCC_takeTask(QCC_TaskQueue *q, QCC_Boolean steal) {
+  QCC_Task *task = NULL;
+
+  pthread_mutex_lock(&q->lock);
+  if (q->head < q->tail) {
+    task = steal ? q->tasks[--q->tail] : q->tasks[q->head++];
+    q->cost -= task->cost;
+  }
+  pthread_mutex_unlock(&q->lock);
+  return task;
+}
+
+static QCC_Task* QCC_nextTask(QCC_Scheduler *sched, int idx) {
+  QCC_Task *task = QCC_takeTask(&sched->queues[idx], QCC_FALSE);
+  int victim, i;
+
+  while (!task) {
+    /* The victim may be emptied before stealing from it: look again */
+    double most = 0;
+    victim = -1;
+    for (i=0; i<sched->threads; i++) {
+      QCC_TaskQueue *q = &sched->queues[i];
+      pthread_mutex_lock(&q->lock);
+      if (q->head < q->tail && (victim < 0 || q->cost > most)) {
+        victim = i;
+        most = q->cost;
+      }
+      pthread_mutex_unlock(&q->lock);
+    }
+    if (victim < 0) return NULL;
+    task = QCC_takeTask(&sched->queues[victim], QCC_TRUE);
+  }
+  return task;
+}
+
+static void* QCC_schedulerWorker(void *arg) {
+  QCC_SchedulerThread *t = arg;
+  QCC_Task *task;
+
+  QCC_schedulerThread = QCC_TRUE;
+  while ((task = QCC_nextTask(t->sched, t->idx))) t->sched->run(t->sched, task);
+  return NULL;
+}
+
+static int QCC_compareTaskCost(const void *a, const void *b) {
+  const QCC_Task *x = *(QCC_Task * const *) a, *y = *(QCC_Task * const *) b;
+  return (x->cost < y->cost) - (x->cost > y->cost);
+}
+
+/* Run all the tasks on the pool, dealing them by decreasing cost */
+static void QCC_runTasks(QCC_Scheduler *sched, QCC_Task **tasks, int tasksN) {
+  QCC_SchedulerThread *threads = calloc(sched->threads, sizeof(QCC_SchedulerThread));
+  int i;
+
+  qsort(tasks, tasksN, sizeof(QCC_Task *), QCC_compareTaskCost);
+  for (i=0; i<sched->threads; i++) {
+    QCC_TaskQueue *q = &sched->queues[i];
+    q->head = q->tail = 0;
+    q->cost = 0;
+  }
+  for (i=0; i<tasksN; i++) {
+    QCC_TaskQueue *q = &sched->queues[i % sched->threads];
+    q->tasks[q->tail++] = tasks[i];
+    q->cost += tasks[i]->cost;
+  }
+
+  for (i=0; i<sched->threads; i++) {
+    threads[i] = (QCC_SchedulerThread) { .sched=sched, .idx=i };
+    pthread_create(&threads[i].thread, NULL, QCC_schedulerWorker, &threads[i]);
+  }
+  for (i=0; i<sched->threads; i++) pthread_join(threads[i].thread, NULL);
+  free(threads);
+}
+
+/*
+ * Estimate the cost of a task by timing a few of its cases, spread over
+ * the run so that they sample the whole size curve.
+ */
+static void QCC_probeTask(QCC_Scheduler *sched, QCC_Task *task) {
+  QCC_Property *p = task->property;
+  QCC_Plan *plan = QCC_newPlan(p->prop, p->genNum, p->gens);
+  double start = QCC_now();
+  int i;
+
+  plan->runSeed = task->seed;
+  for (i=0; i<QCC_COST_PROBES; i++) {
+    plan->cases = (uint64_t) p->num * i / QCC_COST_PROBES;
+    QCC_planStep(plan);
+  }
+  task->cost = (QCC_now() - start) / QCC_COST_PROBES * p->num;
+  QCC_freePlan(plan);
+}
+
+/*
+ * Run a task. With several threads its report is buffered and printed in
+ * one piece once the task is over. The run seed is drawn from a generator
+ * seeded by the task, so it does not depend on the thread running it.
+ */
+static void QCC_runTask(QCC_Scheduler *sched, QCC_Task *task) {
+  QCC_Property *p = task->property;
+  QCC_Boolean buffered = sched->threads > 1;
+  QCC_Plan *plan;
+  QCC_Sink report, *prevSink;
+  QCC_Rng rng, *prevRng;
+  double start = QCC_now();
+
+  if (!buffered) printf("Property %s (%d of %d)\n", p->name, ++sched->done, sched->tasksN);
+
+  QCC_rngSeed(&rng, task->seed);
+  prevRng = QCC_setRng(&rng);
+  QCC_initBufferSink(&report, NULL, 0);
+  prevSink = QCC_setReportSink(buffered ? &report : NULL);
+
+  plan = QCC_newPlan(p->prop, p->genNum, p->gens);
+  QCC_setPlanName(plan, p->name);
+  task->ret = QCC_planRun(plan, p->num, p->maxFail);
+  task->seconds = QCC_now() - start;
+  QCC_freePlan(plan);
+
+  QCC_setReportSink(prevSink);
+  QCC_setRng(prevRng);
+
+  if (buffered) {
+    pthread_mutex_lock(&sched->outputLock);
+    printf("Property %s (%d of %d)\n", p->name, ++sched->done, sched->tasksN);
+    fwrite(report.buf, 1, report.len, stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&sched->outputLock);
+  }
+  QCC_freeSink(&report);
+}
+
+int QCC_runRegistered(int threads, const char *filter) {
+  QCC_Task *tasks = malloc(sizeof(QCC_Task) * (QCC_propertiesN ? QCC_propertiesN : 1));
+  QCC_Task **order = malloc(sizeof(QCC_Task *) * (QCC_propertiesN ? QCC_propertiesN : 1));
+  QCC_Scheduler sched = { .threads=threads, .done=0, .tasksN=0 };
+  int passed = 0, failed = 0, gaveUp = 0, ret = 0;
+  double start = QCC_now();
+  QCC_Task *slowest = NULL;
+  int i;
+
+  for (i=0; i<QCC_propertiesN; i++) {
+    if (filter && *filter && fnmatch(filter, QCC_properties[i].name, 0)) continue;
+    tasks[sched.tasksN] = (QCC_Task) { .property=&QCC_properties[i], .seed=QCC_rngNext(QCC_getRng()),
+                                        .cost=0, .seconds=0, .ret=0 };
+    order[sched.tasksN] = &tasks[sched.tasksN];
+    sched.tasksN++;
+  }
+
+  if (sched.threads <= 0) sched.threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (sched.threads > sched.tasksN) sched.threads = sched.tasksN;
+  if (sched.threads <= 1) sched.threads = 1;
+
+  sched.queues = calloc(sched.threads, sizeof(QCC_TaskQueue));
+  for (i=0; i<sched.threads; i++) {
+    pthread_mutex_init(&sched.queues[i].lock, NULL);
+    sched.queues[i].tasks = malloc(sizeof(QCC_Task *) * (sched.tasksN ? sched.tasksN : 1));
+  }
+  pthread_mutex_init(&sched.outputLock, NULL);
+
+  if (sched.threads > 1) {
+    /* Order only matters when properties compete for threads */
+    sched.run = QCC_probeTask;
+    QCC_runTasks(&sched, order, sched.tasksN);
+    sched.run = QCC_runTask;
+    QCC_runTasks(&sched, order, sched.tasksN);
+  } else {
+    /* In registration order, on the calling thread so isolation applies */
+    for (i=0; i<sched.tasksN; i++) QCC_runTask(&sched, &tasks[i]);
+  }
+
+  for (i=0; i<sched.tasksN; i++) {
+    if (tasks[i].ret == 1) failed++;
+    else if (tasks[i].ret == -1) gaveUp++;
+    else passed++;
+    if (tasks[i].ret == 1 || (tasks[i].ret == -1 && ret == 0)) ret = tasks[i].ret;
+    if (!slowest || tasks[i].seconds > slowest->seconds) slowest = &tasks[i];
+  }
+  printf("%d properties: %d passed, %d falsified, %d gave up (%.3fs)\n",
+         sched.tasksN, passed, failed, gaveUp, QCC_now() - start);
+  if (slowest)
+    printf("Slowest property: %s (%.3fs)\n", slowest->property->name, slowest->seconds);
+
+  for (i=0; i<sched.threads; i++) {
+    pthread_mutex_destroy(&sched.queues[i].lock);
+    free(sched.queues[i].tasks);
+  }
+  pthread_mutex_destroy(&sched.outputLock);
+  free(sched.queues);
+  free(order);
+  free(tasks);
+  return ret;
 }
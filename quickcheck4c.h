@@ -9,13 +9,20 @@
 #define QUICKCHECK4C_C
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
 
-/* Default ranges used for type generation */
-#define QCC_LONG_FROM -RAND_MAX/2
-#define QCC_LONG_TO RAND_MAX/2
-#define QCC_INT_FROM -RAND_MAX/2
-#define QCC_INT_TO RAND_MAX/2
+/*
+ * Default ranges used for type generation. The integer ones are the
+ * extremes of the types, both included, as for the RI generators: ranges
+ * passed to the R generators exclude their upper bound.
+ */
+#define QCC_LONG_FROM LONG_MIN
+#define QCC_LONG_TO LONG_MAX
+#define QCC_INT_FROM INT_MIN
+#define QCC_INT_TO INT_MAX
 #define QCC_DOUBLE_FROM ((double) -(RAND_MAX/2))
 #define QCC_DOUBLE_TO ((double) (RAND_MAX/2))
 #define QCC_FLOAT_FROM ((float) -(RAND_MAX/2))
@@ -58,6 +65,37 @@ typedef enum { QCC_OK=1, QCC_FAIL=0, QCC_NOTHING=-1 } QCC_TestStatus;
  */
 typedef char* (*QCC_showValue)(void *value, int len);
 
+/**
+ * Destination of value representations written incrementally.
+ * A sink either appends to a growable, always NUL terminated, buffer or
+ * writes straight to a stream (see QCC_initBufferSink and
+ * QCC_initFileSink).
+ *
+ * @param buf Buffer written so far (buffer sinks only)
+ * @param len Length of the buffer content
+ * @param cap Allocated size of the buffer
+ * @param file Stream written to (NULL for buffer sinks)
+ * @param maxElems Arrays longer than this are elided in the middle
+ *                 (0 to write them in full)
+ */
+typedef struct QCC_Sink {
+  char *buf;
+  size_t len;
+  size_t cap;
+  FILE *file;
+  int maxElems;
+} QCC_Sink;
+
+/**
+ * Signature of function used to write values in a human readable
+ * fashion to a sink, without allocating intermediate strings.
+ *
+ * @param sink Sink to write to
+ * @param value Pointer to the value to write
+ * @param len Lenght of the data (used to keep track of array lengths)
+ */
+typedef void (*QCC_writeValue)(QCC_Sink *sink, void *value, int len);
+
 /**
  * Signature of function used to free generated values.
  *
@@ -65,6 +103,48 @@ typedef char* (*QCC_showValue)(void *value, int len);
  */
 typedef void (*QCC_freeValue)(void *value);
 
+/**
+ * Signature of function used to hash generated values, so that repeated
+ * cases can be detected (see QCC_setDedup). Equal values must have equal
+ * hashes.
+ *
+ * @param value Pointer to the value to hash
+ * @param len Length of the value (1 for simple types, length for arrays)
+ * @return 64 bits hash of the value
+ */
+typedef uint64_t (*QCC_hashValue)(void *value, int len);
+
+struct QCC_GenValue;
+
+/**
+ * Signature of function used to shrink generated values.
+ * Shrink candidates are enumerated by index, simpler candidates first,
+ * so that no candidate list needs to be materialized.
+ * Calling this function allocates a new value that must be freed by the
+ * caller.
+ *
+ * @param value Generated value to shrink
+ * @param idx Index of the shrink candidate to build
+ * @return The idx-th candidate smaller than value or NULL if there are no
+ *         more candidates
+ */
+typedef struct QCC_GenValue* (*QCC_shrinkValue)(struct QCC_GenValue *value, int idx);
+
+struct QCC_Rng;
+
+/**
+ * Signature of function used to mutate generated values, so that searches
+ * can move to neighbouring arguments (see QCC_searchWorstCase).
+ * Calling this function allocates a new value that must be freed by the
+ * caller.
+ *
+ * @param value Generated value to mutate
+ * @param rng Generator the mutation is drawn from
+ * @return A random neighbour of value (e.g. the same array with two
+ *         elements swapped) or NULL if the value can't be mutated
+ */
+typedef struct QCC_GenValue* (*QCC_mutateValue)(struct QCC_GenValue *value, struct QCC_Rng *rng);
+
 /**
  * Structure defining a generated value.
  * It specifies the value itself (alongside its length in case
@@ -76,12 +156,25 @@ typedef void (*QCC_freeValue)(void *value);
  * @param n Length of the value (1 for simple types, length for arrays)
  * @param show Function to get string representation of the value
  * @param free Function to free the memory of the value
+ * @param shrink Function to get smaller versions of the value
+ *               (NULL if the value can't be shrunk)
+ * @param write Function to write the value to a sink, preferred to show
+ *              when reporting (NULL to fall back to show)
+ * @param hash Function to hash the value (NULL to hash its written form);
+ *             built-in values hash their bytes
+ * @param mutate Function to get neighbours of the value (NULL if the
+ *               value can't be mutated); built-in numbers are nudged and
+ *               arrays and strings rearranged
  */
 typedef struct QCC_GenValue {
   void *value;
   int n;
   QCC_showValue show;
   QCC_freeValue free;
+  QCC_shrinkValue shrink;
+  QCC_writeValue write;
+  QCC_hashValue hash;
+  QCC_mutateValue mutate;
 } QCC_GenValue;
 
 /**
@@ -171,14 +264,187 @@ QCC_TestStatus QCC_xor(QCC_TestStatus prop1Status, QCC_TestStatus prop2Status);
 QCC_TestStatus QCC_not(QCC_TestStatus propStatus);
 
 /**
- * Initialize the random generator using a specific seed.
+ * State of a random number generator (xoshiro256**).
+ * Every thread owns a default generator used by all the built-in
+ * generators. Independent generators can be created with QCC_rngSeed or
+ * QCC_rngSplit and installed on the current thread with QCC_setRng.
+ */
+typedef struct QCC_Rng {
+  uint64_t s[4];
+} QCC_Rng;
+
+/**
+ * Initialize the random generator of the current thread using a specific
+ * seed.
  *
  * @param seed The seed to use or 0 to automatically select seed
  */
 void QCC_init(int seed);
 
+/**
+ * Initialize a random generator state from a 64 bit seed.
+ *
+ * @param rng Generator state to initialize
+ * @param seed Seed to use
+ */
+void QCC_rngSeed(QCC_Rng *rng, uint64_t seed);
+
+/**
+ * Draw 64 uniformly distributed random bits advancing the generator state.
+ *
+ * @param rng Generator state
+ * @return Random 64 bit value
+ */
+uint64_t QCC_rngNext(QCC_Rng *rng);
+
+/**
+ * Draw a uniformly distributed integer in [0, n), without modulo bias.
+ *
+ * @param rng Generator state
+ * @param n Upper bound (excluded)
+ * @return Random value in [0, n), 0 if n is 0
+ */
+uint64_t QCC_rngBelow(QCC_Rng *rng, uint64_t n);
+
+/**
+ * Split a generator in two independent streams.
+ * The child takes over the current stream of rng while rng jumps 2^128
+ * steps ahead, so the two streams never overlap in practice.
+ *
+ * @param rng Generator to split
+ * @param child Generator state receiving the new stream
+ */
+void QCC_rngSplit(QCC_Rng *rng, QCC_Rng *child);
+
+/**
+ * Get the generator used by the current thread.
+ *
+ * @return The generator installed with QCC_setRng or the thread default one
+ */
+QCC_Rng* QCC_getRng();
+
+/**
+ * Install a generator on the current thread.
+ * All the generators invoked afterwards by this thread draw from rng.
+ *
+ * @param rng Generator to install or NULL to restore the thread default one
+ * @return The previously installed generator (NULL for the default one)
+ */
+QCC_Rng* QCC_setRng(QCC_Rng *rng);
+
+/**
+ * Size curve: maps the index of a case in a run to its size, in
+ * [0, maxSize].
+ *
+ * @param caseIndex Index of the case in the run
+ * @param maxSize Maximum size
+ * @return Size of the case
+ */
+typedef int (*QCC_sizeCurve)(uint64_t caseIndex, int maxSize);
+
+/**
+ * Size curve cycling from 0 to maxSize, then starting over (default).
+ */
+int QCC_sizeCycle(uint64_t caseIndex, int maxSize);
+
+/**
+ * Size curve growing from 0 to maxSize, then staying there.
+ */
+int QCC_sizeRamp(uint64_t caseIndex, int maxSize);
+
+/**
+ * Size curve always returning maxSize, i.e. no growth at all.
+ */
+int QCC_sizeMax(uint64_t caseIndex, int maxSize);
+
+/**
+ * Set how the size of the cases grows along a run.
+ *
+ * The size bounds how big generated values are: the first cases of a run
+ * are small and cheap, and find most bugs, later ones grow up to the
+ * maximum size. The size of a case only depends on its index, so
+ * QCC_replay reproduces it. The setting is read when a case starts.
+ *
+ * @param maxSize Maximum size (100 by default)
+ * @param curve Size curve (NULL for QCC_sizeCycle)
+ */
+void QCC_setSize(int maxSize, QCC_sizeCurve curve);
+
+/**
+ * Get the size of the case being generated.
+ * Generators can use it to bound the values they produce: at the maximum
+ * size they should span their whole range.
+ *
+ * @return The size of the current case, or the maximum size outside of
+ *         a run
+ */
+int QCC_getSize();
+
+/**
+ * Set how often generators produce edge values rather than random ones.
+ *
+ * Edge values are the values bugs gather around, which uniform draws
+ * almost never hit: for integers the range bounds, 0, 1 and -1; for
+ * floating point values the range bounds, 0.0, -0.0, 1.0 and -1.0, plus
+ * the extreme finite values, infinities and NaN for the unranged
+ * generators; for arrays and strings the lengths 0, 1 and the longest one.
+ * Besides the random injection, the first cases of each run draw edge
+ * values only, enumerating them deterministically so that the edges of
+ * each argument, and their pairs, are tried first. Edge values are part of
+ * the case, so QCC_replay and the failure database reproduce them. By
+ * default 5% of the values are edge values and the first 16 cases are
+ * edge cases.
+ *
+ * @param probability Probability of drawing an edge value (0 disables
+ *                    injection)
+ * @param prefix Number of edge cases opening each run (0 disables them)
+ */
+void QCC_setEdgeCases(double probability, int prefix);
+
+/**
+ * Decide whether the value being generated is an edge value.
+ * Custom generators call it with the number of their edge values, then
+ * produce the edge value returned, or a random value on -1. Each call is
+ * one draw of the enumeration of the edge cases (see QCC_setEdgeCases).
+ *
+ * @param n Number of edge values of the generator
+ * @return Index of the edge value to produce, in [0, n), or -1 to draw a
+ *         random value
+ */
+int QCC_edgeIndex(int n);
+
+/**
+ * Make a choice among n options, for generators of finite domains.
+ *
+ * Out of enumerations the choice is drawn uniformly from the QCC_getRng
+ * generator. While a domain is enumerated (see QCC_testEnumerate) every
+ * option is taken in turn instead, option 0 first: custom generators
+ * producing their values from choices only become enumerable, as do the
+ * built-in integer, boolean and character generators and QCC_genOneOf and
+ * QCC_genFrequency. Generators asking for QCC_getRng can't be enumerated.
+ *
+ * @param n Number of options
+ * @return The option taken, in [0, n) (0 if n is 0)
+ */
+uint64_t QCC_choose(uint64_t n);
+
+/**
+ * Set whether QCC_testForAll (and QCC_planRun) enumerate small domains.
+ *
+ * When enabled, a run whose generators are all enumerable and whose
+ * domain has at most num tuples runs each tuple exactly once (see
+ * QCC_testEnumerate) rather than num random cases, which proves the
+ * property if it passes. Runs in isolation mode (see QCC_setIsolation)
+ * are not enumerated. Enabled by default.
+ *
+ * @param enabled QCC_TRUE to enumerate small domains
+ */
+void QCC_setAutoEnumerate(QCC_Boolean enabled);
+
 /**
  * Adds a label to the test stamps.
+ * Reports give the share of the cases having each label: a label added
+ * several times by a case counts once.
  *
  * @param stamps Stamps associated to the current test
  * @param label Label to add to the test stamps
@@ -197,8 +463,12 @@ void QCC_label(QCC_Stamp **stamps, char *label);
  * alongside its distribution.
  *
  * If a set of arguments falsifying the property is found, the testing is
- * interrupted immediately and a failure string is printed alongside the
- * set of arguments which caused the failure.
+ * interrupted immediately, the arguments are shrunk (see
+ * QCC_setShrinkBudget) and a failure string is printed alongside the
+ * smallest set of arguments found which still falsifies the property.
+ * Each case draws its arguments from a seed derived from the run seed and
+ * the case index, at a size growing with the index (see QCC_setSize),
+ * which are printed too: QCC_replay runs that single case again.
  *
  * @parm num Number of successful test to perform
  * @parm maxFail Maximum number of unsuccessful argument generation
@@ -212,6 +482,755 @@ void QCC_label(QCC_Stamp **stamps, char *label);
  */
 int QCC_testForAll(int num, int maxFail, QCC_property prop, int genNum, ...);
 
+/**
+ * Version of QCC_testForAll naming the property, so that its falsifying
+ * cases are recorded in and replayed from the failure database (see
+ * QCC_setFailureDatabase).
+ *
+ * @param name Name of the property, which must be stable across runs
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return Same as QCC_testForAll
+ */
+int QCC_testForAllNamed(const char *name, int num, int maxFail, QCC_property prop, int genNum, ...);
+
+/**
+ * Run again a single case of a previous run, as printed when the property
+ * was falsified, and report it as QCC_testForAll does.
+ *
+ * Only that case is generated, whatever its index. The case runs in the
+ * calling process even in isolation mode (see QCC_setIsolation), which
+ * makes it convenient to debug.
+ *
+ * @param runSeed Seed of the run
+ * @param caseIndex Index of the case in the run
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return 0 (the case passed), -1 (the case was discarded),
+ *         1 (property falsified)
+ */
+int QCC_replay(uint64_t runSeed, uint64_t caseIndex, QCC_property prop, int genNum, ...);
+
+/**
+ * Order in which QCC_testEnumerate goes through the tuples of a domain.
+ * Lexicographic order varies the last choice first; diagonal order runs
+ * all the tuples made of choices up to 0, then up to 1, and so on.
+ */
+typedef enum { QCC_LEXICOGRAPHIC, QCC_DIAGONAL } QCC_EnumOrder;
+
+/**
+ * Test a property on every tuple of arguments of a finite domain.
+ *
+ * Each generator makes its choices through QCC_choose, and every
+ * combination of choices is run exactly once, each choice being bounded by
+ * depth: as integers are chosen closest to their shrink target first, a
+ * depth d enumerates the integers within d/2 of it, in the spirit of
+ * SmallCheck. Filters discard the tuples they reject. When every tuple was
+ * run the domain is reported exhausted and the property is proved over
+ * it. Values drawn at random rather than chosen are the same in every
+ * tuple, so their domain is not exhausted. A falsifying tuple is shrunk and
+ * reported as QCC_testForAll does, with its index in the enumeration,
+ * which is the same at every run. Isolation (see QCC_setIsolation) and the
+ * failure database are not applied.
+ *
+ * @param depth Largest choice enumerated (negative for no bound, which
+ *              only terminates on finite domains)
+ * @param order Order of the tuples
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return 0 (all the tuples passed),
+ *         -1 (gave up after maxFail unsuccessful arguments generation),
+ *         1 (property falsified)
+ */
+int QCC_testEnumerate(int depth, QCC_EnumOrder order, int maxFail, QCC_property prop, int genNum, ...);
+
+/**
+ * Set the failure database, a file recording the cases which falsified
+ * named properties.
+ *
+ * Whenever a named property is falsified the seed, size and edge case (see
+ * QCC_setEdgeCases) of the falsifying case are appended to the database,
+ * unless they are already there. When a named property is run, the cases
+ * recorded for it are replayed first, before any new random case: if one
+ * of them still falsifies the property it is reported right away,
+ * otherwise replayed cases are not counted. Replaying is reliable as long
+ * as the generators draw their values from the QCC_getRng generator. The
+ * file is append-only, made of 24 bytes records in host byte order, and
+ * can be shared by any number of programs. The database is disabled by
+ * default.
+ *
+ * @param path Path of the database, created if missing (NULL disables it)
+ */
+void QCC_setFailureDatabase(const char *path);
+
+/**
+ * Set the budget available to shrink a falsifying set of arguments.
+ *
+ * Shrinking greedily replaces each argument with the first candidate
+ * returned by its shrink function that still falsifies the property,
+ * until no candidate does or the budget is exhausted.
+ * By default at most 1000 property evaluations and 1 second are spent.
+ *
+ * @param maxSteps Maximum number of property evaluations (0 disables
+ *                 shrinking)
+ * @param maxSeconds Maximum time spent shrinking (0 for no time limit)
+ */
+void QCC_setShrinkBudget(int maxSteps, double maxSeconds);
+
+/**
+ * Enable per-case arena allocation in the test runners.
+ *
+ * When enabled, each thread running test cases owns an arena which is
+ * reset before every case. Generated values, their QCC_GenValue headers and
+ * the arguments array are then bump-allocated from it (see QCC_alloc):
+ * QCC_freeAlloc leaves the memory of the arena to it, and only frees the
+ * memory obtained elsewhere. Arena allocation is disabled by default. The
+ * setting is read when a run starts.
+ *
+ * @param chunkSize Size in bytes of the memory chunks backing the arena
+ *                  (0 disables arena allocation)
+ */
+void QCC_setArena(size_t chunkSize);
+
+/**
+ * Skip the cases of a run whose arguments were already tested in it.
+ *
+ * The arguments of each case are hashed (see QCC_hashValue) into a
+ * fingerprint kept by the plan for the whole run: a case repeating one is
+ * discarded without evaluating the property, and counts towards maxFail
+ * like any other discarded case, so that runs over domains smaller than
+ * num give up rather than loop. The number of duplicates skipped and of
+ * unique cases tested is reported. Fingerprints take 8 bytes each, in a
+ * table growing up to twice maxCases entries: once maxCases fingerprints
+ * are kept the table is cleared and cases seen before may run again, so
+ * memory stays bounded on long runs. Cases with equal fingerprints are
+ * taken as equal, which for 64 bits fingerprints is a negligible risk.
+ * Duplicates are detected per plan, i.e. per worker in
+ * QCC_testForAllParallel and in isolation mode. Enumerated domains (see
+ * QCC_testEnumerate) have no duplicates to skip. Disabled by default.
+ *
+ * @param maxCases Number of fingerprints kept (0 disables deduplication)
+ */
+void QCC_setDedup(int maxCases);
+
+/**
+ * Run the cases of QCC_testForAll (and QCC_planRun) isolated from the
+ * runner, so that a property which crashes or hangs can't take it down.
+ *
+ * Cases run in a pool of worker processes forked when a run starts and
+ * reused for all its cases. Each case is seeded from the run seed and its
+ * index, so the runner can rebuild the arguments of any case from its
+ * seed. A worker killed by a signal, exiting, or not completing a case
+ * within timeout seconds is reported as falsifying the property with the
+ * arguments of the case it was running, which are not shrunk. Ordinary
+ * failures are shrunk in a forked process as well. Workers see the state
+ * of the program as of when the run started, and labels travel back to the
+ * runner only for successful cases. QCC_testForAllParallel, and
+ * QCC_runRegistered with several threads, ignore this setting. Isolation
+ * is disabled by default.
+ *
+ * @param workers Number of worker processes (0 disables isolation)
+ * @param timeout Maximum time in seconds a case may take (0 for no limit)
+ */
+void QCC_setIsolation(int workers, double timeout);
+
+/**
+ * Parallel version of QCC_testForAll.
+ *
+ * The num successful tests are split among threads workers, each one
+ * seeding its cases from its own run seed drawn from the generator of the
+ * calling thread. The maxFail budget is shared among all
+ * the workers. As soon as any worker falsifies the property all the others
+ * are stopped and the failure is reported exactly as QCC_testForAll does.
+ * Labels gathered by each worker are merged in worker order once all the
+ * workers terminated.
+ *
+ * Properties and generators must be thread safe: the built-in generators
+ * are.
+ *
+ * @param threads Number of worker threads (0 to use one per online CPU)
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return Same as QCC_testForAll
+ */
+int QCC_testForAllParallel(int threads, int num, int maxFail, QCC_property prop, int genNum, ...);
+
+/**
+ * Number of cases checked by each call of a batch property.
+ */
+#define QCC_BATCH_LANES 64
+
+/**
+ * Batch version of a property, checking n cases (lanes) at once.
+ *
+ * The arguments are passed column-wise: columns[i] points to n values of
+ * the type of the i-th QCC_Column, and lane k is made of the k-th value of
+ * every column. Checks written as plain loops over the columns can then be
+ * vectorized by the compiler.
+ *
+ * @param columns One array of n values per column
+ * @param n Number of lanes, at most QCC_BATCH_LANES
+ * @return Bitmap of the lanes falsifying the property (bit k set if lane k
+ *         failed, 0 if all of them passed)
+ */
+typedef uint64_t (*QCC_batchProperty)(void **columns, int n);
+
+/**
+ * Column generator of a batch property.
+ *
+ * fill writes n values in [from, to) drawn from rng, or in [from, to] for
+ * the built-in integer columns. Lanes are turned into arguments of the
+ * single-case property with a value holding the lane value, followed by
+ * from and to if bounded, shown, written and shrunk by show, write and
+ * shrink. The built-in columns below match the values of
+ * the simple types generators.
+ *
+ * @param elemSize Size of a value
+ * @param fill Fill a column
+ * @param show Show function of the lane values
+ * @param write Write function of the lane values
+ * @param shrink Shrink function of the lane values
+ * @param bounded Whether from and to are stored after the lane values
+ * @param from Lower bound of the values (included)
+ * @param to Upper bound of the values (excluded, included for integers)
+ */
+typedef struct QCC_Column {
+  size_t elemSize;
+  void (*fill)(QCC_Rng *rng, void *buf, int n, const void *from, const void *to);
+  QCC_showValue show;
+  QCC_writeValue write;
+  QCC_shrinkValue shrink;
+  QCC_Boolean bounded;
+  union { long l; int i; double d; float f; } from, to;
+} QCC_Column;
+
+QCC_Column QCC_columnLong();
+QCC_Column QCC_columnLongR(long from, long to);
+QCC_Column QCC_columnInt();
+QCC_Column QCC_columnIntR(int from, int to);
+QCC_Column QCC_columnDouble();
+QCC_Column QCC_columnDoubleR(double from, double to);
+QCC_Column QCC_columnFloat();
+QCC_Column QCC_columnFloatR(float from, float to);
+QCC_Column QCC_columnBoolean();
+QCC_Column QCC_columnChar();
+
+/**
+ * Batch version of QCC_testForAll, for cheap properties whose cost is
+ * dominated by calling them once per case.
+ *
+ * Columns are filled QCC_BATCH_LANES values at a time with the bulk
+ * generators and checked by batchProp. Every lane it reports as failing is
+ * evaluated again by prop on its own, which has the final word: a lane
+ * falsifying prop is shrunk and reported as QCC_testForAll does, together
+ * with the run seed, batch and lane to pass to QCC_replayBatch. Lanes can
+ * only be discarded or labeled by prop, so labels are gathered from
+ * those lanes only. Lanes failed by batchProp but passed by prop are
+ * counted and reported, as the two properties should agree. Isolation
+ * (see QCC_setIsolation), the failure database and edge values (see
+ * QCC_setEdgeCases) are not applied.
+ *
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @param batchProp Batch property to test
+ * @parm prop Single-case version of batchProp
+ * @param colNum Number of columns specified as vararg
+ * @param ... colNum QCC_Column generating the arguments
+ * @return Same as QCC_testForAll
+ */
+int QCC_testForAllBatch(int num, int maxFail, QCC_batchProperty batchProp, QCC_property prop, int colNum, ...);
+
+/**
+ * Run again a single lane of a batch, as printed when the property was
+ * falsified by QCC_testForAllBatch, and report it as QCC_replay does.
+ *
+ * @param runSeed Seed of the run
+ * @param batchIndex Index of the batch in the run
+ * @param lane Lane of the batch, less than QCC_BATCH_LANES
+ * @parm prop Single-case property to test
+ * @param colNum Number of columns specified as vararg
+ * @param ... colNum QCC_Column generating the arguments
+ * @return Same as QCC_replay (-1 if lane is out of range)
+ */
+int QCC_replayBatch(uint64_t runSeed, uint64_t batchIndex, int lane, QCC_property prop, int colNum, ...);
+
+/**
+ * Maximum number of threads of QCC_testStateMachineParallel.
+ */
+#define QCC_MAX_STATE_THREADS 8
+
+/**
+ * Command of a state machine (see QCC_StateMachine).
+ *
+ * The model passed to pre, gen and post is the state of the model before
+ * the command runs, which next then updates. A command may be chosen only
+ * in the states where pre holds. Commands of parallel programs may run in
+ * any order allowed by their concurrency: interleavings violating pre
+ * can't explain a history, so commands run concurrently should be total
+ * (e.g. pop on an empty stack returning an error code that post checks).
+ *
+ * @param name Name of the command, used in reports and as label
+ * @param pre Whether the command can run in a state of the model (NULL if
+ *            always)
+ * @param gen Generate the argument of the command in a state of the model
+ *            (NULL if it takes none); a NULL argument discards the program
+ * @param run Run the command on the system under test, returning its
+ *            result
+ * @param post Whether the result of the command is the one expected in a
+ *             state of the model (NULL if any result is)
+ * @param next Update the model as the command does (NULL if it doesn't
+ *             change the state)
+ */
+typedef struct QCC_Command {
+  const char *name;
+  QCC_Boolean (*pre)(const void *model);
+  QCC_GenValue* (*gen)(const void *model);
+  long (*run)(void *sut, QCC_GenValue *arg);
+  QCC_Boolean (*post)(const void *model, QCC_GenValue *arg, long result);
+  void (*next)(void *model, QCC_GenValue *arg);
+} QCC_Command;
+
+/**
+ * State machine describing a system under test through a model of its
+ * state and the commands it accepts.
+ *
+ * Models are plain values of modelSize bytes, copied and compared
+ * bytewise: they must not own pointers. They are zeroed before initModel
+ * sets the initial state.
+ *
+ * @param modelSize Size of the model
+ * @param initModel Set the initial state of a model (NULL if all zeros)
+ * @param newSut Create a system under test in its initial state
+ * @param freeSut Release a system under test
+ * @param commands Commands of the machine
+ * @param commandsN Number of commands
+ */
+typedef struct QCC_StateMachine {
+  size_t modelSize;
+  void (*initModel)(void *model);
+  void* (*newSut)();
+  void (*freeSut)(void *sut);
+  const QCC_Command *commands;
+  int commandsN;
+} QCC_StateMachine;
+
+/**
+ * Test a system under test against the model of a state machine.
+ *
+ * Each case is a program: a sequence of commands generated by running
+ * the model, growing longer with the generation size. The program runs on
+ * a new system under test, checking the result of every command with its
+ * postcondition. Falsifying programs are shrunk by removing commands and
+ * shrinking their arguments, dropping the candidates which violate some
+ * precondition, and printed with the results of the commands. Commands
+ * are labeled with their names. Runs are otherwise those of
+ * QCC_testForAll.
+ *
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @param sm State machine to test
+ * @return Same as QCC_testForAll
+ */
+int QCC_testStateMachine(int num, int maxFail, const QCC_StateMachine *sm);
+
+/**
+ * Test that a system under test is linearizable with respect to the model
+ * of a state machine.
+ *
+ * Programs are made of a sequential prefix followed by threads parallel
+ * branches. The prefix runs on the calling thread, then the branches run
+ * concurrently on a pool of threads started once for the whole run, each
+ * command being stamped with the times it was invoked and returned. The
+ * resulting history must be explained by some order of the commands
+ * consistent with those times in which every postcondition holds, which
+ * is searched for depth first, remembering the states of the model
+ * already explored. Each program runs several times on a new system under
+ * test, to expose more interleavings. Falsifying programs are shrunk as
+ * in QCC_testStateMachine, and also by moving commands from the branches
+ * to the prefix; shrinking a program falsified by a rare interleaving may
+ * stop early as the candidates pass by chance.
+ *
+ * The commands of the system under test must be thread safe, unlike
+ * those of the model.
+ *
+ * @param threads Number of parallel branches (clamped to [2,
+ *                QCC_MAX_STATE_THREADS])
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @param sm State machine to test
+ * @return Same as QCC_testForAll
+ */
+int QCC_testStateMachineParallel(int threads, int num, int maxFail, const QCC_StateMachine *sm);
+
+/**
+ * Latency budget of a performance property (see QCC_testLatency).
+ *
+ * @param maxSeconds Time the evaluation of any case may take (0 for no
+ *                   limit)
+ * @param percentile Percentile of the times of the cases checked against
+ *                   percentileSeconds, in (0, 1] (e.g. 0.99)
+ * @param percentileSeconds Time the percentile may take (0 for no limit)
+ */
+typedef struct QCC_LatencyBudget {
+  double maxSeconds;
+  double percentile;
+  double percentileSeconds;
+} QCC_LatencyBudget;
+
+/**
+ * Test that a property holds within a latency budget.
+ *
+ * Every evaluation of the property is timed with the monotonic clock; an
+ * evaluation slower than the budget is timed again a couple of times and
+ * the fastest time counts, so that preemptions don't fail cases. A case
+ * taking more than maxSeconds falsifies the property: it is shrunk to
+ * smaller arguments still over the budget and reported as QCC_testForAll
+ * does, with the time it took. Once num cases passed, the percentile of
+ * their times is checked against percentileSeconds: if over it the
+ * slowest case is shrunk in the same way and reported. Passing runs
+ * report the median, 90th and 99th percentiles and maximum of the times.
+ * Failures of the property itself are reported as usual. Isolation (see
+ * QCC_setIsolation), enumeration and the failure database are not
+ * applied.
+ *
+ * Times include whatever the property does besides the code under test,
+ * so it should do little else.
+ *
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @param budget Latency budget of the property
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return Same as QCC_testForAll
+ */
+int QCC_testLatency(int num, int maxFail, QCC_LatencyBudget budget, QCC_property prop, int genNum, ...);
+
+/**
+ * Search the arguments on which a property is the slowest, e.g. to find
+ * inputs triggering the worst-case complexity of an algorithm.
+ *
+ * num cases are run as by QCC_testLatency, then the search climbs from
+ * the slowest one: each step mutates one of the arguments having a
+ * mutate function (see QCC_GenValue), e.g. sorting or reversing a run
+ * of an array, and keeps the mutation if the property passes and is
+ * slower by 5% at least. Both the current and the mutated arguments are
+ * timed 5 times, interleaved, and the mutation only counts as slower if
+ * all its timings are, so that noise doesn't pass for a slowdown. Steps
+ * are bounded by the shrinking budget (see QCC_setShrinkBudget). The
+ * resulting arguments and their time are reported, with the seed of the
+ * case the climb started from (see QCC_replay).
+ *
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @param budget Time the slowest case may take (0 for no limit)
+ * @parm prop Property to time
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return Same as QCC_testForAll, 1 if the slowest case is over budget
+ */
+int QCC_searchWorstCase(int num, int maxFail, double budget, QCC_property prop, int genNum, ...);
+
+/**
+ * Function benchmarked by QCC_benchForAll on generated arguments.
+ *
+ * Results should be used (e.g. stored to a volatile variable), so that
+ * the compiler can't drop the code being measured.
+ *
+ * @param vals Arguments generated by the generators of the benchmark
+ * @param len Number of arguments
+ */
+typedef void (*QCC_benchFunction)(QCC_GenValue **vals, int len);
+
+/**
+ * Set how long QCC_benchForAll warms up and measures each benchmark.
+ * Defaults are 0.1 and 1 seconds.
+ *
+ * @param warmupSeconds Warmup time (0 for a single pass over the inputs)
+ * @param measureSeconds Measurement time, extended until 30 samples at
+ *                       least were taken
+ */
+void QCC_setBenchTime(double warmupSeconds, double measureSeconds);
+
+/**
+ * Compare the benchmarks run by QCC_benchForAll with a baseline file.
+ *
+ * The file is a text file with a line per benchmark, holding its name,
+ * then the mean and 95% confidence interval bounds of its time per
+ * operation in nanoseconds, separated by tabs. A benchmark whose
+ * confidence interval doesn't overlap the one of its baseline changed
+ * significantly: it regressed if its mean is slower by more than
+ * tolerance too. If update is set the results of each benchmark replace
+ * its line in the file (which is created if missing), e.g. to record the
+ * baseline of a commit. Disabled by default.
+ *
+ * @param path Path of the baseline file (NULL disables comparisons)
+ * @param tolerance Relative slowdown tolerated, e.g. 0.05 for 5%
+ * @param update Whether to write the results to the file
+ */
+void QCC_setBenchBaseline(const char *path, double tolerance, QCC_Boolean update);
+
+/**
+ * Benchmark a function on inputs drawn from generators.
+ *
+ * poolSize inputs are generated first, as the cases of a QCC_testForAll
+ * run are (sizes following the size curve, no edge values), and are
+ * released once done, so generation is not measured. The run seed is
+ * drawn from the generator of the calling thread: runs seeded alike
+ * through QCC_init measure the same inputs. The function runs on the
+ * inputs in turn for the warmup time (see QCC_setBenchTime), which also
+ * calibrates how many operations fill a sample of about a millisecond,
+ * then samples are taken for the measurement time. The mean time per
+ * operation is reported with its 95% confidence interval (bootstrapped
+ * from the samples), the median and minimum, the operations per second
+ * and the outlying samples (out of the Tukey fences, 1.5 and 3
+ * interquartile ranges beyond the quartiles). The result is then
+ * compared with the baseline, if any (see QCC_setBenchBaseline).
+ *
+ * @param name Name of the benchmark in reports and in the baseline file
+ *             (no tabs or newlines)
+ * @param poolSize Number of inputs (at least 1)
+ * @param fn Function to benchmark
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return 0 (measured), 1 (regressed with respect to the baseline),
+ *         -1 (gave up after as many discarded inputs as poolSize)
+ */
+int QCC_benchForAll(const char *name, int poolSize, QCC_benchFunction fn, int genNum, ...);
+
+/**
+ * Register a property to be run by QCC_runRegistered.
+ * Properties are usually registered through QCC_REGISTER instead.
+ *
+ * @param name Name of the property (copied), also used by the failure
+ *             database (see QCC_setFailureDatabase)
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @parm prop Property to test
+ * @parm genNum Number of generators
+ * @param gens genNum QCC_gen function to use as generators (copied)
+ */
+void QCC_registerProperty(const char *name, int num, int maxFail, QCC_property prop, int genNum, QCC_gen *gens);
+
+#define QCC_REGISTER_ID(line) QCC_REGISTER_ID_(line)
+#define QCC_REGISTER_ID_(line) QCC_registerProperty_##line
+
+/**
+ * Register a property when the program starts, from any translation unit,
+ * e.g. QCC_REGISTER("sum", 100, 1000, sumProp, QCC_genInt, QCC_genInt).
+ * Generators follow the property, as for QCC_testForAll but without their
+ * count. At most one registration fits a line.
+ */
+#define QCC_REGISTER(name, num, maxFail, prop, ...)                     \
+  __attribute__((constructor)) static void QCC_REGISTER_ID(__LINE__)() { \
+    static QCC_gen gens[] = { NULL, __VA_ARGS__ };                      \
+    QCC_registerProperty(name, num, maxFail, prop,                      \
+                         sizeof(gens) / sizeof(gens[0]) - 1, gens + 1); \
+  }
+
+/**
+ * Run the registered properties whose name matches filter on a pool of
+ * threads, reporting each one as QCC_testForAll does.
+ *
+ * The cost of each property is first estimated by timing a few of its
+ * cases, then properties are dealt to the threads most expensive first;
+ * threads which run out of properties steal them from the others, so the
+ * run takes about as long as its most expensive property. Reports are
+ * buffered and printed in one piece as each property completes. Each
+ * property draws its run seed from a seed drawn from the generator of the
+ * calling thread, whatever thread runs it. Properties run in-process as
+ * with QCC_testForAllParallel, unless threads is 1: they then run in
+ * registration order on the calling thread, and isolation applies (see
+ * QCC_setIsolation).
+ *
+ * @param threads Number of threads (0 to use one per online CPU)
+ * @param filter Shell wildcard pattern matched against the property
+ *               names (NULL or "" to run all of them)
+ * @return 0 (all the properties passed), 1 (a property was falsified),
+ *         -1 (gave up on a property, none falsified)
+ */
+int QCC_runRegistered(int threads, const char *filter);
+
+/**
+ * Opaque compiled test plan.
+ *
+ * A plan binds a property to its generators once and owns the storage
+ * reused by every case run through it: the arguments array, the labels
+ * table and, if enabled (see QCC_setArena), the allocation arena. Running
+ * many cases of the same property through a plan avoids the per-case
+ * vararg resolution and allocations of QCC_forAll.
+ */
+typedef struct QCC_Plan QCC_Plan;
+
+/**
+ * Create a test plan.
+ *
+ * @param prop Property to test
+ * @param genNum Number of generators
+ * @param gens Array of genNum QCC_gen function to use as generators
+ *             (copied)
+ * @return The plan to release with QCC_freePlan
+ */
+QCC_Plan* QCC_newPlan(QCC_property prop, int genNum, QCC_gen *gens);
+
+/**
+ * Name the property of a plan (see QCC_testForAllNamed).
+ *
+ * @param plan Plan to name
+ * @param name Name of the property (copied, NULL to remove the name)
+ */
+void QCC_setPlanName(QCC_Plan *plan, const char *name);
+
+/**
+ * Release a test plan and the arguments of its last case.
+ *
+ * @param plan Plan to release
+ */
+void QCC_freePlan(QCC_Plan *plan);
+
+/**
+ * Run a single case of the plan on newly generated arguments.
+ *
+ * The arguments of the previous case are released first. Successful cases
+ * are counted and their labels aggregated in the plan.
+ *
+ * @param plan Plan to run
+ * @return Status returned by the property
+ */
+QCC_TestStatus QCC_planStep(QCC_Plan *plan);
+
+/**
+ * Retrieve the arguments of the last case run through the plan.
+ *
+ * They remain valid until the next QCC_planStep, QCC_planRun or
+ * QCC_freePlan on the plan.
+ *
+ * @param plan Plan to inspect
+ * @return Array of arguments (NULL if no case was run)
+ */
+QCC_GenValue** QCC_planArguments(QCC_Plan *plan);
+
+/**
+ * Test the plan property as QCC_testForAll does.
+ *
+ * Counters and labels of previous runs are discarded first, so a plan can
+ * be run any number of times.
+ *
+ * @param plan Plan to run
+ * @parm num Number of successful test to perform
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @return Same as QCC_testForAll
+ */
+int QCC_planRun(QCC_Plan *plan, int num, int maxFail);
+
+/**
+ * Run again a single case of the plan property as QCC_replay does.
+ *
+ * @param plan Plan to run
+ * @param runSeed Seed of the run
+ * @param caseIndex Index of the case in the run
+ * @return Same as QCC_replay
+ */
+int QCC_planReplay(QCC_Plan *plan, uint64_t runSeed, uint64_t caseIndex);
+
+/**
+ * Enumerate the domain of the plan property as QCC_testEnumerate does.
+ *
+ * @param plan Plan to run
+ * @param depth Largest choice enumerated (negative for no bound)
+ * @param order Order of the tuples
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @return Same as QCC_testEnumerate
+ */
+int QCC_planEnumerate(QCC_Plan *plan, int depth, QCC_EnumOrder order, int maxFail);
+
+/**
+ * Test a property until a wall-clock budget runs out.
+ *
+ * Cases are run until seconds elapsed, maxFail unsuccessful argument
+ * generation occurred or the property is falsified, and reported as
+ * QCC_testForAll does, followed by the number of cases executed and the
+ * cases per second. The budget may be overrun by about the duration of a
+ * case. Isolation (see QCC_setIsolation) is not applied.
+ *
+ * @param seconds Time budget
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @parm prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return 0 (no falsifying arguments found within the budget),
+ *         -1 (gave up after maxFail unsuccessful arguments generation),
+ *         1 (property falsified)
+ */
+int QCC_testFor(double seconds, int maxFail, QCC_property prop, int genNum, ...);
+
+/**
+ * Test the plan property as QCC_testFor does.
+ *
+ * @param plan Plan to run
+ * @param seconds Time budget
+ * @parm maxFail Maximum number of unsuccessful argument generation
+ * @return Same as QCC_testFor
+ */
+int QCC_planRunFor(QCC_Plan *plan, double seconds, int maxFail);
+
+/**
+ * Split a global time budget across several plans.
+ *
+ * The cost of a case of each plan is measured first, spending 5% of the
+ * budget; the rest is split in proportion to the measured costs, so that
+ * slower properties get more time rather than running far fewer cases than
+ * the fast ones. Each plan is then reported, in order, as QCC_testFor
+ * does.
+ *
+ * @param plans Plans to run
+ * @param plansN Number of plans
+ * @param seconds Time budget of all the plans
+ * @parm maxFail Maximum number of unsuccessful argument generation per plan
+ * @return 1 if any property was falsified, otherwise -1 if any run gave
+ *         up, 0 otherwise
+ */
+int QCC_planRunAllFor(QCC_Plan **plans, int plansN, double seconds, int maxFail);
+
+/**
+ * Print the profile gathered by the test runners.
+ *
+ * Profiling is available only if both the library and the caller are
+ * compiled with QCC_PROFILE defined; otherwise it costs nothing and this
+ * function just says so. Every case run through a plan (and hence through
+ * QCC_testForAll and QCC_testForAllParallel) is timed per phase: generate,
+ * evaluate, label (QCC_label calls and labels aggregation), free, show and
+ * shrink. Timings are aggregated per property and per generator when the
+ * plan is released. Functions are named through dladdr (link with -rdynamic
+ * to resolve non static ones) or by address.
+ */
+void QCC_printProfile();
+
+/**
+ * Export the profile gathered by the test runners as CSV.
+ *
+ * Each line reports kind (property or generator), name, phase, calls,
+ * ticks (TSC cycles on x86, nanoseconds elsewhere) and nanoseconds.
+ *
+ * @param path File to write
+ * @return 0 on success, -1 on error or if profiling is disabled
+ */
+int QCC_exportProfile(const char *path);
+
+/**
+ * Discard the profile gathered so far.
+ */
+void QCC_resetProfile();
+
 /*************************************************************
  * Helper function for generator definitions
  *************************************************************/
@@ -225,30 +1244,234 @@ int QCC_testForAll(int num, int maxFail, QCC_property prop, int genNum, ...);
  * value
  * @param free Pointer to a QCC_FreeValue function to use for free the raw value
  * memory
- * @return Initialized QCC_GenValue
+ * @return Initialized QCC_GenValue (not shrinkable, set its shrink field to
+ * provide shrink candidates and its write field to stream large values)
  */
 QCC_GenValue* QCC_initGenValue(void *value, int n, QCC_showValue show, QCC_freeValue free);
 
+/**
+ * Allocate memory for a generated value.
+ * Inside a test run with arena allocation enabled (see QCC_setArena) the
+ * memory comes from the per-case arena, otherwise from malloc.
+ * Memory obtained this way must be released through QCC_freeAlloc, which
+ * can be used directly as the QCC_freeValue of the generated value.
+ *
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory
+ */
+void* QCC_alloc(size_t size);
+
+/**
+ * Release memory obtained through QCC_alloc (or malloc).
+ * Does nothing for memory of the arena installed on the thread, which is
+ * released when the arena is reset.
+ *
+ * @param value Pointer to the memory to release
+ */
+void QCC_freeAlloc(void *value);
+
+/*************************************************************
+ * Sinks
+ *************************************************************/
+
+/**
+ * Initialize a sink appending to a growable buffer.
+ * The buffer is reallocated as needed, so it must come from malloc; after
+ * writing, sink->buf holds the NUL terminated text and is owned by the
+ * caller (or released through QCC_freeSink).
+ *
+ * @param sink Sink to initialize
+ * @param buf Buffer to reuse (NULL to allocate a new one)
+ * @param cap Allocated size of buf
+ */
+void QCC_initBufferSink(QCC_Sink *sink, char *buf, size_t cap);
+
+/**
+ * Initialize a sink writing straight to a stream.
+ *
+ * @param sink Sink to initialize
+ * @param file Stream to write to
+ */
+void QCC_initFileSink(QCC_Sink *sink, FILE *file);
+
+/**
+ * Release the buffer of a sink.
+ *
+ * @param sink Sink to release
+ */
+void QCC_freeSink(QCC_Sink *sink);
+
+/**
+ * Write n characters to a sink.
+ *
+ * @param sink Sink to write to
+ * @param s Characters to write
+ * @param n Number of characters to write
+ */
+void QCC_sinkWrite(QCC_Sink *sink, const char *s, size_t n);
+
+/**
+ * Write printf-style formatted text to a sink.
+ *
+ * @param sink Sink to write to
+ * @param format Format string
+ */
+void QCC_sinkPrintf(QCC_Sink *sink, const char *format, ...);
+
+/**
+ * Write a generated value to a sink, through its write function if it has
+ * one and through its show function otherwise.
+ *
+ * @param sink Sink to write to
+ * @param value Generated value to write
+ */
+void QCC_writeGenValue(QCC_Sink *sink, QCC_GenValue *value);
+
+/**
+ * Set the maximum number of elements written when reporting falsifying
+ * arrays and strings; longer ones are elided in the middle. By default
+ * they are written in full.
+ *
+ * @param maxElems Maximum number of elements (0 for no limit)
+ */
+void QCC_setShowLimit(int maxElems);
+
+/*************************************************************
+ * Raw value generators
+ *
+ * The QCC_rng* functions write a random value at the given address
+ * drawing from an explicit generator state; the QCC_gen*At versions
+ * draw from the generator of the current thread.
+ * Ranged versions generate values in [from, to); integer versions
+ * without range span the whole type.
+ *************************************************************/
+void QCC_rngLongAtR(QCC_Rng *rng, long *l, long *from, long *to);
+void QCC_rngLongAt(QCC_Rng *rng, long *l);
+void QCC_rngIntAtR(QCC_Rng *rng, int *i, int *from, int *to);
+void QCC_rngIntAt(QCC_Rng *rng, int *i);
+void QCC_rngDoubleAtR(QCC_Rng *rng, double *d, double *from, double *to);
+void QCC_rngDoubleAt(QCC_Rng *rng, double *d);
+void QCC_rngFloatAtR(QCC_Rng *rng, float *f, float *from, float *to);
+void QCC_rngFloatAt(QCC_Rng *rng, float *f);
+void QCC_rngBooleanAt(QCC_Rng *rng, QCC_Boolean *b);
+void QCC_rngCharAt(QCC_Rng *rng, char *c);
+
+void QCC_genLongAtR(long *l, long *from, long *to);
+void QCC_genLongAt(long *l);
+void QCC_genIntAtR(int *i, int *from, int *to);
+void QCC_genIntAt(int *i);
+void QCC_genDoubleAtR(double *d, double *from, double *to);
+void QCC_genDoubleAt(double *d);
+void QCC_genFloatAtR(float *f, float *from, float *to);
+void QCC_genFloatAt(float *f);
+void QCC_genBooleanAt(QCC_Boolean *b);
+void QCC_genCharAt(char *c);
+
+void QCC_rngInt8AtR(QCC_Rng *rng, int8_t *v, int8_t *from, int8_t *to);
+void QCC_rngInt8At(QCC_Rng *rng, int8_t *v);
+void QCC_rngUint8AtR(QCC_Rng *rng, uint8_t *v, uint8_t *from, uint8_t *to);
+void QCC_rngUint8At(QCC_Rng *rng, uint8_t *v);
+void QCC_rngInt16AtR(QCC_Rng *rng, int16_t *v, int16_t *from, int16_t *to);
+void QCC_rngInt16At(QCC_Rng *rng, int16_t *v);
+void QCC_rngUint16AtR(QCC_Rng *rng, uint16_t *v, uint16_t *from, uint16_t *to);
+void QCC_rngUint16At(QCC_Rng *rng, uint16_t *v);
+void QCC_rngInt32AtR(QCC_Rng *rng, int32_t *v, int32_t *from, int32_t *to);
+void QCC_rngInt32At(QCC_Rng *rng, int32_t *v);
+void QCC_rngUint32AtR(QCC_Rng *rng, uint32_t *v, uint32_t *from, uint32_t *to);
+void QCC_rngUint32At(QCC_Rng *rng, uint32_t *v);
+void QCC_rngInt64AtR(QCC_Rng *rng, int64_t *v, int64_t *from, int64_t *to);
+void QCC_rngInt64At(QCC_Rng *rng, int64_t *v);
+void QCC_rngUint64AtR(QCC_Rng *rng, uint64_t *v, uint64_t *from, uint64_t *to);
+void QCC_rngUint64At(QCC_Rng *rng, uint64_t *v);
+void QCC_rngSizeTAtR(QCC_Rng *rng, size_t *v, size_t *from, size_t *to);
+void QCC_rngSizeTAt(QCC_Rng *rng, size_t *v);
+
+/*************************************************************
+ * Bulk raw value generators
+ *
+ * Fill a whole buffer of n values in one call. Large buffers are
+ * filled by 4 interleaved generator lanes seeded from rng, using
+ * AVX2 or SSE2 kernels when the CPU supports them (compile with
+ * QCC_NO_SIMD to always use the scalar kernel). All the kernels
+ * produce the same values.
+ * Ranged versions generate values in [from, to).
+ *************************************************************/
+void QCC_rngFill(QCC_Rng *rng, uint64_t *out, size_t n);
+void QCC_rngFillLongR(QCC_Rng *rng, long *buf, int n, long *from, long *to);
+void QCC_rngFillIntR(QCC_Rng *rng, int *buf, int n, int *from, int *to);
+void QCC_rngFillDoubleR(QCC_Rng *rng, double *buf, int n, double *from, double *to);
+void QCC_rngFillFloatR(QCC_Rng *rng, float *buf, int n, float *from, float *to);
+void QCC_rngFillBoolean(QCC_Rng *rng, QCC_Boolean *buf, int n);
+void QCC_rngFillChar(QCC_Rng *rng, char *buf, int n);
+
 /*************************************************************
  * Simple types generators
+ *
+ * Integer generators without range span the whole type, extremes
+ * included; ranged versions generate values in [from, to), and RI
+ * versions in [first, last], which may include the largest value.
+ * Integers shrink towards 0, or the range bound closest to it.
+ *
+ * Floating point generators without range draw finite values in
+ * [QCC_DOUBLE_FROM, QCC_DOUBLE_TO) or [QCC_FLOAT_FROM, QCC_FLOAT_TO); their
+ * edge values are the bounds, 0, -0, 1, -1, the smallest normal values and
+ * the smallest denormals, those in range only for the ranged versions.
+ * QCC_genDoubleSpecial and QCC_genFloatSpecial also produce the largest
+ * finite values, the infinities and NaN as edge values, for the properties
+ * meant to handle them.
  *************************************************************/
 QCC_GenValue* QCC_genLong();
 QCC_GenValue* QCC_genLongR(long from, long to);
+QCC_GenValue* QCC_genLongRI(long first, long last);
 
 QCC_GenValue* QCC_genInt();
 QCC_GenValue* QCC_genIntR(int from, int to);
+QCC_GenValue* QCC_genIntRI(int first, int last);
 
 QCC_GenValue* QCC_genDouble();
 QCC_GenValue* QCC_genDoubleR(double from, double to);
+QCC_GenValue* QCC_genDoubleSpecial();
 
 QCC_GenValue* QCC_genFloat();
 QCC_GenValue* QCC_genFloatR(float from, float to);
+QCC_GenValue* QCC_genFloatSpecial();
 
 QCC_GenValue* QCC_genBoolean();
 QCC_GenValue* QCC_genChar();
 
+QCC_GenValue* QCC_genInt8();
+QCC_GenValue* QCC_genInt8R(int8_t from, int8_t to);
+QCC_GenValue* QCC_genInt8RI(int8_t first, int8_t last);
+QCC_GenValue* QCC_genUint8();
+QCC_GenValue* QCC_genUint8R(uint8_t from, uint8_t to);
+QCC_GenValue* QCC_genUint8RI(uint8_t first, uint8_t last);
+QCC_GenValue* QCC_genInt16();
+QCC_GenValue* QCC_genInt16R(int16_t from, int16_t to);
+QCC_GenValue* QCC_genInt16RI(int16_t first, int16_t last);
+QCC_GenValue* QCC_genUint16();
+QCC_GenValue* QCC_genUint16R(uint16_t from, uint16_t to);
+QCC_GenValue* QCC_genUint16RI(uint16_t first, uint16_t last);
+QCC_GenValue* QCC_genInt32();
+QCC_GenValue* QCC_genInt32R(int32_t from, int32_t to);
+QCC_GenValue* QCC_genInt32RI(int32_t first, int32_t last);
+QCC_GenValue* QCC_genUint32();
+QCC_GenValue* QCC_genUint32R(uint32_t from, uint32_t to);
+QCC_GenValue* QCC_genUint32RI(uint32_t first, uint32_t last);
+QCC_GenValue* QCC_genInt64();
+QCC_GenValue* QCC_genInt64R(int64_t from, int64_t to);
+QCC_GenValue* QCC_genInt64RI(int64_t first, int64_t last);
+QCC_GenValue* QCC_genUint64();
+QCC_GenValue* QCC_genUint64R(uint64_t from, uint64_t to);
+QCC_GenValue* QCC_genUint64RI(uint64_t first, uint64_t last);
+QCC_GenValue* QCC_genSizeT();
+QCC_GenValue* QCC_genSizeTR(size_t from, size_t to);
+QCC_GenValue* QCC_genSizeTRI(size_t first, size_t last);
+
 /*************************************************************
  * Array types generators
+ *
+ * Lengths are drawn in [0, len) at the maximum size; smaller
+ * sizes shrink the range proportionally (see QCC_getSize).
  *************************************************************/
 QCC_GenValue* QCC_genString();
 QCC_GenValue* QCC_genStringL(int len);
@@ -277,4 +1500,121 @@ QCC_GenValue* QCC_genArrayCharL(int len);
 
 QCC_GenValue* QCC_genArrayString();
 QCC_GenValue* QCC_genArrayStringL(int len, int strLen);
+
+/*************************************************************
+ * Generator combinators
+ *
+ * Combinators build constrained values directly in custom
+ * generators, instead of discarding cases with QCC_imply. E.g.
+ *
+ *   QCC_GenValue* genEven() {
+ *     return QCC_genMap(QCC_genInt(), makeEven);
+ *   }
+ *
+ * Generators may return NULL to discard the case without
+ * evaluating the property; combinators propagate NULL values.
+ * Values built by map, filter and bind shrink through the
+ * values they were built from, so that shrink candidates keep
+ * satisfying the constraints. Filter rejections are reported
+ * by the runners.
+ *************************************************************/
+
+/**
+ * Signature of functions transforming a generated value in place.
+ * The function may replace value->value (and update value->n), as long
+ * as value->free still releases it.
+ *
+ * @param value Value to transform
+ */
+typedef void (*QCC_mapValue)(QCC_GenValue *value);
+
+/**
+ * Signature of predicates on generated values.
+ *
+ * @param value Value to test
+ * @return QCC_TRUE iff the value is acceptable
+ */
+typedef QCC_Boolean (*QCC_predicate)(QCC_GenValue *value);
+
+/**
+ * Signature of functions generating a value depending on another one.
+ * They must not free or keep the value they are given.
+ *
+ * @param value Value the new one depends on
+ * @return A new generated value (NULL to discard the case)
+ */
+typedef QCC_GenValue* (*QCC_bindValue)(QCC_GenValue *value);
+
+/**
+ * Transform a value. Shrink candidates of the value are transformed too,
+ * so map should be a normalization, e.g. rounding to even numbers.
+ *
+ * @param value Value to transform (taken over, may be NULL)
+ * @param map Transformation applied in place
+ * @return The transformed value (NULL if value is NULL)
+ */
+QCC_GenValue* QCC_genMap(QCC_GenValue *value, QCC_mapValue map);
+
+/**
+ * Generate values until one satisfies pred, trying at most 100 times at
+ * the current size. Shrink candidates are filtered as well.
+ *
+ * @param gen Generator to draw values from
+ * @param pred Predicate to satisfy
+ * @return The first value satisfying pred (NULL if none did)
+ */
+QCC_GenValue* QCC_genFilter(QCC_gen gen, QCC_predicate pred);
+
+/**
+ * Version of QCC_genFilter trying at most maxTries times and growing the
+ * size by one after each rejected value, as QuickCheck's suchThat does.
+ *
+ * @param gen Generator to draw values from
+ * @param pred Predicate to satisfy
+ * @param maxTries Maximum number of values generated
+ * @return The first value satisfying pred (NULL if none did)
+ */
+QCC_GenValue* QCC_genSuchThat(QCC_gen gen, QCC_predicate pred, int maxTries);
+
+/**
+ * Generate a value depending on another one, e.g. an array whose length
+ * is a generated number. Shrinking the result shrinks the source first,
+ * generating the result again from it with the same random stream and
+ * size, then shrinks the result itself.
+ *
+ * @param source Value the result depends on (taken over, may be NULL)
+ * @param bind Function generating the result from source
+ * @return The generated result (NULL if source or the result is NULL)
+ */
+QCC_GenValue* QCC_genBind(QCC_GenValue *source, QCC_bindValue bind);
+
+/**
+ * Generate a value with one of genNum generators, picked uniformly.
+ *
+ * @param genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to pick from
+ * @return The generated value
+ */
+QCC_GenValue* QCC_genOneOf(int genNum, ...);
+
+/**
+ * Generate a value with one of genNum generators, picked with
+ * probability proportional to its weight.
+ *
+ * @param genNum Number of generators specified as vararg
+ * @param ... genNum (int weight, QCC_gen generator) pairs
+ * @return The generated value (NULL if all the weights are 0)
+ */
+QCC_GenValue* QCC_genFrequency(int genNum, ...);
+
+/**
+ * Generate a tuple of values, one for each generator. The tuple value is
+ * an array of genNum QCC_GenValue pointers: it must not be modified.
+ * Es: QCC_GenValue **t = QCC_getValue(vals, 0, QCC_GenValue**)
+ *
+ * @param genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return The tuple (NULL if a generator returned NULL)
+ */
+QCC_GenValue* QCC_genTuple(int genNum, ...);
 #endif
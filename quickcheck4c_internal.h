@@ -0,0 +1,48 @@
+/********************************************************************
+ * Copyright (c) 2014, Andrea Zito
+ * All rights reserved.
+ *
+ * License: BSD3
+ ********************************************************************/
+
+/*
+ * Internal entry points of the library, shared with the benchmarks of the
+ * framework (see bench.c). Not part of the public interface.
+ */
+
+#ifndef QUICKCHECK4C_INTERNAL_H
+#define QUICKCHECK4C_INTERNAL_H
+
+#include "quickcheck4c.h"
+
+typedef struct QCC_Result {
+  QCC_TestStatus status;
+  QCC_Stamp *stamps;
+  QCC_GenValue **arguments;
+  int argumentsN;
+} QCC_Result;
+
+/**
+ * Release a generated value and its memory.
+ *
+ * @param value Value to release (NULL is ignored)
+ */
+void QCC_freeGenValue(QCC_GenValue *value);
+
+/**
+ * Generate a single case and run the property on it.
+ *
+ * @param prop Property to test
+ * @parm genNum Number of generators specified as vararg
+ * @param ... genNum QCC_gen function to use as generators
+ * @return The outcome of the case, released with QCC_freeResult
+ */
+QCC_Result QCC_forAll(QCC_property prop, int genNum, ...);
+
+/**
+ * Release the labels and arguments of a case.
+ *
+ * @param res Result returned by QCC_forAll
+ */
+void QCC_freeResult(QCC_Result *res);
+#endif